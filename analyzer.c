@@ -0,0 +1,373 @@
+#include "value.h"
+#include "linkedlist.h"
+#include "talloc.h"
+#include "tokenizer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#ifndef _ANALYZER
+#define _ANALYZER
+
+// A StaticScope describes the frames a lambda, let or letrec form will create:
+// the name of each slot, in order, and whether the slot is bound as soon as
+// the frame exists (a parameter or a let/letrec variable) or only once an
+// internal define runs. parent is the scope of the enclosing form, or NULL for
+// the global frame.
+typedef struct StaticScope {
+    char **names;
+    bool *bound;
+    int size;
+    int capacity;
+    struct StaticScope *parent;
+} StaticScope;
+
+Value *analyzeExpression(Value *expr, StaticScope *scope);
+
+// the keyword of each special form, and its interned copy once formOf() has first run
+char *formNames[] = {NULL, "quote", "lambda", "let", "letrec", "if", "define", "set!", "begin"};
+char *formSymbols[BEGIN_FORM + 1];
+
+// resetFormSymbols
+// params: None
+// returns: Nothing
+// resetFormSymbols() forgets the interned keywords, which tfree() is about to free along with the symbol table
+void resetFormSymbols() {
+    for (int form = QUOTE_FORM; form <= BEGIN_FORM; form++) {
+        formSymbols[form] = NULL;
+    }
+}
+
+// formOf
+// params: expr - a pointer to a Value
+// returns: the special form whose keyword is the symbol at the head of expr, or NO_FORM
+specialForm formOf(Value *expr) {
+    if (typeOf(expr) != CONS_TYPE || typeOf(car(expr)) != SYMBOL_TYPE) {
+        return NO_FORM;
+    }
+    if (formSymbols[QUOTE_FORM] == NULL) {
+        tfreeHook(resetFormSymbols);
+        for (int form = QUOTE_FORM; form <= BEGIN_FORM; form++) {
+            formSymbols[form] = internSymbol(formNames[form], strlen(formNames[form]));
+        }
+    }
+    for (int form = QUOTE_FORM; form <= BEGIN_FORM; form++) {
+        if (car(expr) -> s == formSymbols[form]) {
+            return form;
+        }
+    }
+    return NO_FORM;
+}
+
+// replaceCar
+// params: cell - a pointer to a CONS_TYPE Value; value - a pointer to a Value
+// returns: Nothing
+// replaceCar() stores value as the car of cell, which may already have been promoted by the collector
+void replaceCar(Value *cell, Value *value) {
+    consCell(cell) -> car = value;
+    gcWriteBarrier(cell);
+}
+
+// openScope
+// params: scope - a pointer to the StaticScope to set up; parent - a pointer to the enclosing StaticScope, or NULL
+// returns: Nothing
+void openScope(StaticScope *scope, StaticScope *parent) {
+    scope -> names = NULL;
+    scope -> bound = NULL;
+    scope -> size = 0;
+    scope -> capacity = 0;
+    scope -> parent = parent;
+}
+
+// closeScope
+// params: scope - a pointer to a StaticScope that is no longer needed
+// returns: Nothing
+void closeScope(StaticScope *scope) {
+    free(scope -> names);
+    free(scope -> bound);
+}
+
+// findName
+// params: scope - a pointer to a StaticScope; name - an interned symbol name
+// returns: the slot holding name in scope, or -1 if there is none
+int findName(StaticScope *scope, char *name) {
+    for (int i = 0; i < scope -> size; i++) {
+        if (scope -> names[i] == name) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// addName
+// params: scope - a pointer to a StaticScope; name - an interned symbol name; isBound - whether the slot is bound as soon as the frame exists
+// returns: the slot holding name in scope
+// addName() gives name the next free slot, unless it already has one. Binding a name twice is an error that is reported when the frame is filled in.
+int addName(StaticScope *scope, char *name, bool isBound) {
+    int slot = findName(scope, name);
+    if (slot != -1) {
+        return slot;
+    }
+
+    if (scope -> size == scope -> capacity) {
+        scope -> capacity = scope -> capacity == 0 ? 8 : scope -> capacity * 2;
+        scope -> names = realloc(scope -> names, scope -> capacity * sizeof(char *));
+        scope -> bound = realloc(scope -> bound, scope -> capacity * sizeof(bool));
+        if (scope -> names == NULL || scope -> bound == NULL) {
+            printf("Memory error: out of memory\n");
+            exit(1);
+        }
+    }
+    scope -> names[scope -> size] = name;
+    scope -> bound[scope -> size] = isBound;
+    scope -> size++;
+    return scope -> size - 1;
+}
+
+// makeLocal
+// params: depth - the number of frames to go up; slot - the slot in that frame; symbol - the SYMBOL_TYPE Value being resolved; next - what the reference means while the slot is unbound
+// returns: a pointer to a new LOCAL_TYPE Value
+Value *makeLocal(int depth, int slot, Value *symbol, Value *next) {
+    Value *local = gcAllocValue();
+    local -> type = LOCAL_TYPE;
+    local -> lr.depth = depth;
+    local -> lr.slot = slot;
+    local -> lr.symbol = symbol;
+    local -> lr.next = next;
+    return local;
+}
+
+// makeScopeHead
+// params: form - LAMBDA_FORM, LET_FORM or LETREC_FORM; scope - a pointer to the StaticScope of the form
+// returns: a pointer to a new SCOPE_TYPE Value
+Value *makeScopeHead(specialForm form, StaticScope *scope) {
+    Value *head = gcAllocValue();
+    head -> type = SCOPE_TYPE;
+    head -> sh.form = form;
+    head -> sh.frameSize = scope -> size;
+    return head;
+}
+
+// resolveSymbol
+// params: symbol - a SYMBOL_TYPE Value being referred to; scope - a pointer to the innermost StaticScope to search; depth - the number of frames between the reference and scope
+// returns: a LOCAL_TYPE Value for the innermost local variable named by symbol, or symbol itself if it can only be global
+// a variable introduced by a define chains on to whatever the name means further out, since it is only bound once the define runs
+Value *resolveSymbol(Value *symbol, StaticScope *scope, int depth) {
+    if (scope == NULL) {
+        return symbol;
+    }
+    int slot = findName(scope, symbol -> s);
+    if (slot == -1) {
+        return resolveSymbol(symbol, scope -> parent, depth + 1);
+    }
+    Value *next = NULL;
+    if (!scope -> bound[slot]) {
+        next = resolveSymbol(symbol, scope -> parent, depth + 1);
+    }
+    return makeLocal(depth, slot, symbol, next);
+}
+
+// collectDefines
+// params: expr - a pointer to a Value representing an expression; scope - a pointer to the StaticScope expr is evaluated in
+// returns: Nothing
+// collectDefines() gives a slot in scope to every variable that expr defines in scope's frame, so that references appearing before the define can find it
+void collectDefines(Value *expr, StaticScope *scope) {
+    specialForm form = formOf(expr);
+    if (typeOf(expr) != CONS_TYPE || form == QUOTE_FORM || form == LAMBDA_FORM || form == LETREC_FORM) {
+        return;
+    }
+
+    if (form == LET_FORM) {
+        // only the initial values of a let are evaluated in the enclosing frame
+        if (typeOf(cdr(expr)) == CONS_TYPE) {
+            Value *bindings = car(cdr(expr));
+            while (typeOf(bindings) == CONS_TYPE) {
+                Value *binding = car(bindings);
+                if (typeOf(binding) == CONS_TYPE && typeOf(cdr(binding)) == CONS_TYPE) {
+                    collectDefines(car(cdr(binding)), scope);
+                }
+                bindings = cdr(bindings);
+            }
+        }
+        return;
+    }
+
+    if (form == DEFINE_FORM && typeOf(cdr(expr)) == CONS_TYPE && typeOf(car(cdr(expr))) == SYMBOL_TYPE) {
+        addName(scope, car(cdr(expr)) -> s, false);
+    }
+    Value *current = expr;
+    while (typeOf(current) == CONS_TYPE) {
+        collectDefines(car(current), scope);
+        current = cdr(current);
+    }
+}
+
+// collectEach
+// params: list - a pointer to a Value representing a list of expressions; scope - a pointer to a StaticScope
+// returns: Nothing
+void collectEach(Value *list, StaticScope *scope) {
+    while (typeOf(list) == CONS_TYPE) {
+        collectDefines(car(list), scope);
+        list = cdr(list);
+    }
+}
+
+// analyzeEach
+// params: list - a pointer to a Value representing a list of expressions; scope - a pointer to the StaticScope they are evaluated in
+// returns: Nothing
+// analyzeEach() replaces each expression in list with its analyzed form
+void analyzeEach(Value *list, StaticScope *scope) {
+    while (typeOf(list) == CONS_TYPE) {
+        replaceCar(list, analyzeExpression(car(list), scope));
+        list = cdr(list);
+    }
+}
+
+// bindNames
+// params: bindings - a pointer to a Value representing the binding list of a let or letrec; scope - a pointer to the StaticScope of the form
+// returns: Nothing
+// bindNames() gives each bound variable a slot in scope and replaces its name with a reference to that slot
+void bindNames(Value *bindings, StaticScope *scope) {
+    while (typeOf(bindings) == CONS_TYPE) {
+        Value *binding = car(bindings);
+        if (typeOf(binding) == CONS_TYPE && typeOf(car(binding)) == SYMBOL_TYPE) {
+            int slot = addName(scope, car(binding) -> s, true);
+            replaceCar(binding, makeLocal(0, slot, car(binding), NULL));
+        }
+        bindings = cdr(bindings);
+    }
+}
+
+// analyzeInitialValues
+// params: bindings - a pointer to a Value representing the binding list of a let or letrec; scope - a pointer to the StaticScope the values are evaluated in
+// returns: Nothing
+void analyzeInitialValues(Value *bindings, StaticScope *scope) {
+    while (typeOf(bindings) == CONS_TYPE) {
+        Value *binding = car(bindings);
+        if (typeOf(binding) == CONS_TYPE && typeOf(cdr(binding)) == CONS_TYPE) {
+            replaceCar(cdr(binding), analyzeExpression(car(cdr(binding)), scope));
+        }
+        bindings = cdr(bindings);
+    }
+}
+
+// analyzeLambda
+// params: expr - a pointer to a Value representing a lambda expression; scope - a pointer to the StaticScope it is evaluated in
+// returns: Nothing
+// the parameters take the first slots of the frame, in order, followed by the variables defined in the body
+void analyzeLambda(Value *expr, StaticScope *scope) {
+    StaticScope inner;
+    openScope(&inner, scope);
+    Value *args = cdr(expr);
+    if (typeOf(args) == CONS_TYPE) {
+        Value *param = car(args);
+        bool noParams = false;
+        while (typeOf(param) == CONS_TYPE) {
+            if (typeOf(car(param)) == SYMBOL_TYPE) {
+                addName(&inner, car(param) -> s, true);
+            } else if (typeOf(car(param)) == NULL_TYPE) {
+                // a parameter list containing () is treated as empty
+                noParams = true;
+            }
+            param = cdr(param);
+        }
+        if (noParams) {
+            inner.size = 0;
+        }
+        collectEach(cdr(args), &inner);
+        analyzeEach(cdr(args), &inner);
+    }
+    replaceCar(expr, makeScopeHead(LAMBDA_FORM, &inner));
+    closeScope(&inner);
+}
+
+// analyzeLet
+// params: expr - a pointer to a Value representing a let expression; scope - a pointer to the StaticScope it is evaluated in
+// returns: Nothing
+void analyzeLet(Value *expr, StaticScope *scope) {
+    StaticScope inner;
+    openScope(&inner, scope);
+    Value *args = cdr(expr);
+    if (typeOf(args) == CONS_TYPE) {
+        analyzeInitialValues(car(args), scope);
+        bindNames(car(args), &inner);
+        collectEach(cdr(args), &inner);
+        analyzeEach(cdr(args), &inner);
+    }
+    replaceCar(expr, makeScopeHead(LET_FORM, &inner));
+    closeScope(&inner);
+}
+
+// analyzeLetRec
+// params: expr - a pointer to a Value representing a letrec expression; scope - a pointer to the StaticScope it is evaluated in
+// returns: Nothing
+// unlike let, the initial values are evaluated in the new frame
+void analyzeLetRec(Value *expr, StaticScope *scope) {
+    StaticScope inner;
+    openScope(&inner, scope);
+    Value *args = cdr(expr);
+    if (typeOf(args) == CONS_TYPE) {
+        bindNames(car(args), &inner);
+        Value *bindings = car(args);
+        while (typeOf(bindings) == CONS_TYPE) {
+            Value *binding = car(bindings);
+            if (typeOf(binding) == CONS_TYPE && typeOf(cdr(binding)) == CONS_TYPE) {
+                collectDefines(car(cdr(binding)), &inner);
+            }
+            bindings = cdr(bindings);
+        }
+        collectEach(cdr(args), &inner);
+        analyzeInitialValues(car(args), &inner);
+        analyzeEach(cdr(args), &inner);
+    }
+    replaceCar(expr, makeScopeHead(LETREC_FORM, &inner));
+    closeScope(&inner);
+}
+
+// analyzeExpression
+// params: expr - a pointer to a Value representing an expression; scope - a pointer to the StaticScope it is evaluated in, or NULL at top level
+// returns: a pointer to a Value representing the analyzed expression
+// analyzeExpression() leaves anything it does not recognize alone, so that the compiler reports the same errors it would have
+Value *analyzeExpression(Value *expr, StaticScope *scope) {
+    specialForm form = formOf(expr);
+    if (typeOf(expr) == SYMBOL_TYPE) {
+        return resolveSymbol(expr, scope, 0);
+    } else if (typeOf(expr) != CONS_TYPE || form == QUOTE_FORM) {
+        return expr;
+    } else if (form == LAMBDA_FORM) {
+        analyzeLambda(expr, scope);
+    } else if (form == LET_FORM) {
+        analyzeLet(expr, scope);
+    } else if (form == LETREC_FORM) {
+        analyzeLetRec(expr, scope);
+    } else if (form == DEFINE_FORM || form == SET_FORM) {
+        Value *args = cdr(expr);
+        if (typeOf(args) == CONS_TYPE && typeOf(car(args)) == SYMBOL_TYPE) {
+            if (form == SET_FORM) {
+                replaceCar(args, resolveSymbol(car(args), scope, 0));
+            } else if (scope != NULL) {
+                // a define always binds a variable in the current frame
+                int slot = addName(scope, car(args) -> s, false);
+                replaceCar(args, makeLocal(0, slot, car(args), NULL));
+            }
+        }
+        if (typeOf(args) == CONS_TYPE) {
+            analyzeEach(cdr(args), scope);
+        }
+    } else if (form == IF_FORM || form == BEGIN_FORM) {
+        analyzeEach(cdr(expr), scope);
+    } else {
+        analyzeEach(expr, scope);
+    }
+    return expr;
+}
+
+// analyze
+// params: tree - a pointer to a Value representing one top-level form
+// returns: a pointer to a Value representing the form, ready to be evaluated in the global frame
+Value *analyze(Value *tree) {
+    return analyzeExpression(tree, NULL);
+}
+
+#endif
@@ -0,0 +1,17 @@
+#include "value.h"
+
+#ifndef _ANALYZER
+#define _ANALYZER
+
+// Prepares one top-level form from the parse tree for evaluation, and returns
+// the form to evaluate. References to local variables are replaced with
+// LOCAL_TYPE Values giving the frame and slot they live in, and the keywords of
+// lambda, let and letrec forms with SCOPE_TYPE Values giving the size of the
+// frames they create. The form is rewritten in place.
+Value *analyze(Value *tree);
+
+// Returns the special form expr is, judging by the symbol at its head, or
+// NO_FORM if it is not a list headed by one of their keywords.
+specialForm formOf(Value *expr);
+
+#endif
@@ -0,0 +1,477 @@
+#include "value.h"
+#include "linkedlist.h"
+#include "talloc.h"
+#include "tokenizer.h"
+#include "parser.h"
+#include "analyzer.h"
+#include "interpreter.h"
+#include "output.h"
+#include "number.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Micro-benchmarks for the allocator, the reader, variable lookup, calls,
+// printing and number conversion. Each line of the report gives the time per
+// operation and the bytes allocated per operation, with talloc or on the
+// garbage-collected heap. Programs are written to a temporary file and read
+// back the way the interpreter reads a file given on the command line. Build
+// and run with "make bench". Before the number conversions are timed, doubles
+// are checked to read back as written, and the benchmarks stop if any does
+// not.
+
+// The cost of one iteration of a benchmark loop.
+typedef struct LoopCost {
+    double seconds;
+    double bytes;
+} LoopCost;
+
+// how many times the loops written in Scheme go round
+#define LOOP_ITERATIONS 1000000
+
+// how many times each loop is timed, the best time being the one reported, since a loop and the baseline it is
+// compared with are both slowed down at random by whatever else the machine is doing
+#define LOOP_RUNS 3
+
+// path of the temporary file programs are written to
+char sourcePath[] = "/tmp/schemebenchXXXXXX";
+
+// the global frame that programs are evaluated in
+Frame *global = NULL;
+
+// how many loops have been defined, to give each its own global name, since a global can be defined only once
+int loopCount = 0;
+
+// now
+// params: None
+// returns: the time in seconds from some fixed point, by the monotonic clock
+double now() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+// report
+// params: name - what was measured; count - how many operations were timed; seconds - how long they took in all;
+// bytes - how many bytes they allocated in all
+// returns: Nothing
+void report(char *name, long count, double seconds, double bytes) {
+    printf("%-48s %9.1f ns/op %9.1f B/op\n", name, seconds * 1e9 / count, bytes / count);
+}
+
+// writeSource
+// params: text - the text of a program
+// returns: Nothing
+// writeSource replaces the contents of the temporary file with text
+void writeSource(char *text) {
+    FILE *file = fopen(sourcePath, "w");
+    size_t size = strlen(text);
+    if (file == NULL || fwrite(text, 1, size, file) != size) {
+        printf("Benchmark error: could not write %s\n", sourcePath);
+        exit(1);
+    }
+    fclose(file);
+}
+
+// run
+// params: text - the text of a program
+// returns: Nothing
+// run evaluates each top-level form of the program in the global frame, as interpret() does, without printing
+void run(char *text) {
+    writeSource(text);
+    openInput(sourcePath);
+    Value *form = readDatum();
+    while (form != NULL) {
+        eval(analyze(form), global);
+        gcSafePoint();
+        form = readDatum();
+    }
+    releaseInput();
+}
+
+// timeProgram
+// params: definition - a Scheme program to run first, untimed; call - a Scheme expression to time, which runs a loop
+// of LOOP_ITERATIONS iterations
+// returns: the cost of each iteration of the loop, in the fastest of LOOP_RUNS runs
+LoopCost timeProgram(char *definition, char *call) {
+    run(definition);
+    LoopCost best;
+    for (int i = 0; i < LOOP_RUNS; i++) {
+        size_t bytes = bytesAllocated();
+        double start = now();
+        run(call);
+        LoopCost cost = {(now() - start) / LOOP_ITERATIONS, (double)(bytesAllocated() - bytes) / LOOP_ITERATIONS};
+        if (i == 0 || cost.seconds < best.seconds) {
+            best = cost;
+        }
+    }
+    return best;
+}
+
+// timeLoop
+// params: body - Scheme expressions to evaluate on each iteration, in which i is the number of iterations left
+// returns: the cost of each iteration of a loop that evaluates body
+LoopCost timeLoop(char *body) {
+    char definition[4096];
+    char call[64];
+    snprintf(definition, sizeof(definition),
+             "(define bench-loop%d (lambda (i) (if (= i 0) 0 (begin %s (bench-loop%d (- i 1))))))", loopCount, body,
+             loopCount);
+    snprintf(call, sizeof(call), "(bench-loop%d %d)", loopCount, LOOP_ITERATIONS);
+    loopCount++;
+    return timeProgram(definition, call);
+}
+
+// reportLoop
+// params: name - what was measured; cost - the cost of an iteration; baseline - the cost of an iteration of the same
+// loop without the operations; perIteration - how many operations each iteration performs
+// returns: Nothing
+// reportLoop reports an operation that costs less than the noise left in the timings as taking no time, rather than
+// a negative one
+void reportLoop(char *name, LoopCost cost, LoopCost baseline, int perIteration) {
+    double seconds = cost.seconds > baseline.seconds ? cost.seconds - baseline.seconds : 0;
+    report(name, (long)LOOP_ITERATIONS * perIteration, seconds * LOOP_ITERATIONS,
+           (cost.bytes - baseline.bytes) * LOOP_ITERATIONS);
+}
+
+// repeat
+// params: buffer - where to write; size - the room in buffer; expr - a Scheme expression; times - how many copies
+// returns: buffer, holding times copies of expr separated by spaces
+char *repeat(char *buffer, size_t size, char *expr, int times) {
+    buffer[0] = '\0';
+    for (int i = 0; i < times; i++) {
+        strncat(buffer, expr, size - strlen(buffer) - 2);
+        strcat(buffer, " ");
+    }
+    return buffer;
+}
+
+// benchAllocator
+// params: None
+// returns: Nothing
+// benchAllocator frees everything allocated so far first, so that it times talloc from an empty first chunk
+void benchAllocator() {
+    tfree();
+    int count = 4000000;
+    size_t bytes = bytesAllocated();
+    double start = now();
+    for (int i = 0; i < count; i++) {
+        char *block = talloc(16 + (i & 3) * 16);
+        block[0] = (char)i;
+    }
+    report("talloc, 16 to 64 bytes", count, now() - start, bytesAllocated() - bytes);
+
+    start = now();
+    tfree();
+    report("tfree, per block", count, now() - start, 0);
+
+    bytes = bytesAllocated();
+    start = now();
+    Value *list = makeNull();
+    for (int i = 0; i < count; i++) {
+        list = cons(makeInt(i), list);
+    }
+    report("cons", count, now() - start, bytesAllocated() - bytes);
+    tfree();
+}
+
+// benchReader
+// params: None
+// returns: Nothing
+// benchReader times tokenizing and parsing generated programs of increasing size
+void benchReader() {
+    int sizes[] = {1000, 10000, 100000, 1000000};
+    for (int i = 0; i < 4; i++) {
+        char *text = malloc((size_t)sizes[i] * 80 + 1);
+        size_t used = 0;
+        for (int j = 0; j < sizes[i]; j++) {
+            used = used + sprintf(text + used, "(define item%d (quote (%d -%d.25 \"text\" #t (nested symbol) ())))\n",
+                                  j % 1000, j, j % 97);
+        }
+        writeSource(text);
+        free(text);
+
+        char name[64];
+        openInput(sourcePath);
+        size_t bytes = bytesAllocated();
+        double start = now();
+        Value *tokens = tokenize();
+        double seconds = now() - start;
+        bytes = bytesAllocated() - bytes;
+        releaseInput();
+        long tokenCount = length(tokens);
+        snprintf(name, sizeof(name), "tokenize, %zu KB, per token", used / 1024);
+        report(name, tokenCount, seconds, bytes);
+
+        openInput(sourcePath);
+        bytes = bytesAllocated();
+        start = now();
+        parse();
+        seconds = now() - start;
+        bytes = bytesAllocated() - bytes;
+        releaseInput();
+        snprintf(name, sizeof(name), "parse, %zu KB, per token", used / 1024);
+        report(name, tokenCount, seconds, bytes);
+    }
+}
+
+// benchLookup
+// params: None
+// returns: Nothing
+// benchLookup times references to global variables with more and more globals defined, and to local variables more
+// and more frames up from the one they are referenced in
+void benchLookup() {
+    char body[2048];
+    char name[64];
+    LoopCost baseline = timeLoop(repeat(body, sizeof(body), "i", 10));
+    reportLoop("loop iteration (the baseline)", baseline, (LoopCost){0, 0}, 1);
+
+    int widths[] = {16, 1024, 65536};
+    int defined = 0;
+    for (int i = 0; i < 3; i++) {
+        char *definitions = malloc((size_t)widths[i] * 40 + 1);
+        size_t used = 0;
+        for (; defined < widths[i]; defined++) {
+            used = used + sprintf(definitions + used, "(define global%d %d)\n", defined, defined);
+        }
+        definitions[used] = '\0';
+        run(definitions);
+        free(definitions);
+
+        char reference[32];
+        snprintf(reference, sizeof(reference), "global%d", widths[i] / 2);
+        LoopCost cost = timeLoop(repeat(body, sizeof(body), reference, 10));
+        snprintf(name, sizeof(name), "global variable, %d globals", widths[i]);
+        reportLoop(name, cost, baseline, 10);
+    }
+
+    // the loop runs inside lets nested depth deep inside the one binding v, so that v is depth + 2 frames up from
+    // the loop's own frame, past the lets and the letrec
+    int depths[] = {0, 4, 16};
+    for (int i = 0; i < 3; i++) {
+        char text[4096];
+        char lets[2048] = "";
+        char closing[64] = "";
+        for (int j = 0; j < depths[i]; j++) {
+            snprintf(lets + strlen(lets), sizeof(lets) - strlen(lets), "(let ((p%d %d) (q%d 0)) ", j, j, j);
+            strcat(closing, ")");
+        }
+        LoopCost costs[2];
+        for (int reference = 0; reference <= 1; reference++) {
+            char call[64];
+            snprintf(text, sizeof(text),
+                     "(define bench-depth%d (lambda (n) (let ((v 1)) %s(letrec ((loop (lambda (i) (if (= i 0) v "
+                     "(begin %s (loop (- i 1))))))) (loop n)))%s))",
+                     loopCount, lets, repeat(body, sizeof(body), reference ? "v" : "i", 10), closing);
+            snprintf(call, sizeof(call), "(bench-depth%d %d)", loopCount, LOOP_ITERATIONS);
+            loopCount++;
+            costs[reference] = timeProgram(text, call);
+        }
+        snprintf(name, sizeof(name), "local variable, %d frames up", depths[i] + 2);
+        reportLoop(name, costs[1], costs[0], 10);
+    }
+}
+
+// benchCalls
+// params: None
+// returns: Nothing
+// benchCalls times calls to a lambda and to a primitive function, beyond the cost of evaluating their arguments
+void benchCalls() {
+    char body[2048];
+    run("(define identity (lambda (x) x)) (define pair (quote (1 2)))");
+    LoopCost baseline = timeLoop(repeat(body, sizeof(body), "identity i", 10));
+    reportLoop("call to a lambda", timeLoop(repeat(body, sizeof(body), "(identity i)", 10)), baseline, 10);
+
+    baseline = timeLoop(repeat(body, sizeof(body), "car pair", 10));
+    reportLoop("call to a primitive (car)", timeLoop(repeat(body, sizeof(body), "(car pair)", 10)), baseline, 10);
+
+    baseline = timeLoop(repeat(body, sizeof(body), "i i", 10));
+    reportLoop("cons from Scheme", timeLoop(repeat(body, sizeof(body), "(cons i i)", 10)), baseline, 10);
+}
+
+// benchPrinting
+// params: None
+// returns: Nothing
+// benchPrinting times writeValue() on long lists, with stdout sent to /dev/null while it runs
+void benchPrinting() {
+    int count = 1000000;
+    Value *integers = makeNull();
+    Value *doubles = makeNull();
+    Value *nested = makeNull();
+    for (int i = 0; i < count; i++) {
+        integers = cons(makeInt(i % 100000 * 7919), integers);
+        Value *number = gcAllocValue();
+        number -> type = DOUBLE_TYPE;
+        number -> d = i / 7.0;
+        doubles = cons(number, doubles);
+        nested = cons(nested, makeNull());
+    }
+
+    fflush(stdout);
+    int savedOutput = dup(1);
+    int devNull = open("/dev/null", O_WRONLY);
+    dup2(devNull, 1);
+
+    double times[3];
+    Value *lists[] = {integers, doubles, nested};
+    for (int i = 0; i < 3; i++) {
+        double start = now();
+        writeValue(lists[i]);
+        flushOutput();
+        fflush(stdout);
+        times[i] = now() - start;
+    }
+
+    dup2(savedOutput, 1);
+    close(devNull);
+    close(savedOutput);
+    report("writeValue, list of integers, per item", count, times[0], 0);
+    report("writeValue, list of doubles, per item", count, times[1], 0);
+    report("writeValue, lists nested 1000000 deep, per list", count, times[2], 0);
+}
+
+// checkNumbers
+// params: None
+// returns: Nothing
+// checkNumbers writes doubles from all over the range, and the ones that print specially, with formatDouble(), reads
+// the text back with the tokenizer, and exits if any comes back different. It does the same for literals with
+// exponents, which strtod must agree with.
+void checkNumbers() {
+    double special[] = {0.0, -0.0, 1.0, 0.1, 1e-7, 9.999999999999999e-8, 1e21, 999999999999999900000.0, 1e22,
+                        1.2345678901234568e29, 5e-324, DBL_MIN, DBL_MAX, -DBL_MAX, INFINITY, -INFINITY, NAN};
+    char *literals[] = {"1e5", "1E-5", "-2.5e+3", "+.5e1", "7.e2", "0e400", "1e400", "-1e400", "1e-400", "4e-320",
+                        "123456789012345678901e-30", "9007199254740993e22", "0.000000000000000000000000001e27"};
+    int specialCount = sizeof(special) / sizeof(double);
+    int literalCount = sizeof(literals) / sizeof(char *);
+    int count = specialCount + 100000;
+    double *numbers = malloc(count * sizeof(double));
+    char *text = malloc((size_t)count * (DOUBLE_TEXT_LENGTH + 1) + literalCount * 40 + 1);
+    size_t used = 0;
+    for (int i = 0; i < count; i++) {
+        if (i < specialCount) {
+            numbers[i] = special[i];
+        } else {
+            // random bits, so every exponent turns up, subnormal numbers and NaNs included
+            uint64_t bits = 0;
+            for (int j = 0; j < 4; j++) {
+                bits = bits << 16 | (rand() & 0xFFFF);
+            }
+            memcpy(&numbers[i], &bits, sizeof(double));
+        }
+        used = used + formatDouble(numbers[i], text + used);
+        text[used] = '\n';
+        used++;
+    }
+    for (int i = 0; i < literalCount; i++) {
+        used = used + sprintf(text + used, "%s\n", literals[i]);
+    }
+    text[used] = '\0';
+    writeSource(text);
+    free(text);
+
+    openInput(sourcePath);
+    Value *token = nextToken();
+    for (int i = 0; i < count + literalCount; i++) {
+        double expected = i < count ? numbers[i] : strtod(literals[i - count], NULL);
+        bool same = token != NULL && typeOf(token) == DOUBLE_TYPE
+                    && (isnan(expected) ? isnan(token -> d) : !memcmp(&token -> d, &expected, sizeof(double)));
+        if (!same) {
+            char written[DOUBLE_TEXT_LENGTH + 1];
+            written[formatDouble(expected, written)] = '\0';
+            printf("Number error: %s did not read back as the same double\n", i < count ? written : literals[i - count]);
+            exit(1);
+        }
+        token = nextToken();
+    }
+    releaseInput();
+    free(numbers);
+}
+
+// benchNumbers
+// params: None
+// returns: Nothing
+// benchNumbers compares the conversions in number.c with the C library's
+void benchNumbers() {
+    int count = 1000000;
+    double *numbers = malloc(count * sizeof(double));
+    char (*literals)[32] = malloc(count * sizeof(*literals));
+    int *lengths = malloc(count * sizeof(int));
+    char text[512];
+    long sink = 0;
+    for (int i = 0; i < count; i++) {
+        numbers[i] = (double)rand() / 1000.0;
+        lengths[i] = snprintf(literals[i], 32, "%d.%03d", rand() % 100000, rand() % 1000);
+    }
+
+    double start = now();
+    for (int i = 0; i < count; i++) {
+        sink = sink + snprintf(text, sizeof(text), "%lf", numbers[i]);
+    }
+    report("printf %lf (the old way of writing doubles)", count, now() - start, 0);
+
+    start = now();
+    for (int i = 0; i < count; i++) {
+        sink = sink + snprintf(text, sizeof(text), "%.17g", numbers[i]);
+    }
+    report("printf %.17g", count, now() - start, 0);
+
+    start = now();
+    for (int i = 0; i < count; i++) {
+        sink = sink + formatDouble(numbers[i], text);
+    }
+    report("formatDouble", count, now() - start, 0);
+
+    double sum = 0;
+    start = now();
+    for (int i = 0; i < count; i++) {
+        sum = sum + strtod(literals[i], NULL);
+    }
+    report("strtod", count, now() - start, 0);
+
+    start = now();
+    for (int i = 0; i < count; i++) {
+        sum = sum + parseDouble(literals[i], lengths[i]);
+    }
+    report("parseDouble", count, now() - start, 0);
+
+    // keep the results, so that the loops are not optimized away
+    if (sink == 0 || sum == 0) {
+        printf("\n");
+    }
+    free(numbers);
+    free(literals);
+    free(lengths);
+}
+
+int main() {
+    int file = mkstemp(sourcePath);
+    if (file < 0) {
+        printf("Benchmark error: could not create %s\n", sourcePath);
+        return 1;
+    }
+    close(file);
+
+    benchAllocator();
+    benchReader();
+
+    global = makeGlobalFrame();
+    gcPushRoot(&global);
+    benchLookup();
+    benchCalls();
+    gcPopRoots(1);
+    releaseGlobalFrame();
+
+    benchPrinting();
+    checkNumbers();
+    benchNumbers();
+
+    unlink(sourcePath);
+    tfree();
+    return 0;
+}
@@ -0,0 +1,30 @@
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+// Runs a command and writes its peak resident set size, in kilobytes, to
+// stderr. bench/run.py runs the interpreter through this rather than directly,
+// because Linux counts the memory of the process that a program is started
+// from in the program's peak, and this process is much smaller than Python.
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s command [argument ...]\n", argv[0]);
+        return 1;
+    }
+    pid_t child = fork();
+    if (child == 0) {
+        execv(argv[1], argv + 1);
+        perror(argv[1]);
+        _exit(127);
+    }
+    int status;
+    struct rusage usage;
+    if (child < 0 || wait4(child, &status, 0, &usage) < 0) {
+        perror(argv[0]);
+        return 1;
+    }
+    fprintf(stderr, "%ld\n", usage.ru_maxrss);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+}
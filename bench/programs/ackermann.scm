@@ -0,0 +1,12 @@
+; Ackermann's function: a mix of tail and non-tail calls reaching a recursion
+; depth in the thousands.
+(define ack
+  (lambda (m n)
+    (if (= m 0)
+        (+ n 1)
+        (if (= n 0)
+            (ack (- m 1) 1)
+            (ack (- m 1) (ack m (- n 1)))))))
+
+(ack 2 9)
+(ack 3 9)
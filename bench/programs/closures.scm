@@ -0,0 +1,34 @@
+; Closure-heavy code: counters that keep state with set!, composition, and
+; higher-order functions applied to lambdas made on every iteration.
+(define make-counter
+  (lambda (step)
+    (let ((count 0))
+      (lambda ()
+        (set! count (+ count step))
+        count))))
+
+(define compose
+  (lambda (f g)
+    (lambda (x) (f (g x)))))
+
+(define add
+  (lambda (n)
+    (lambda (x) (+ x n))))
+
+(define apply-times
+  (lambda (f n x)
+    (if (= n 0)
+        x
+        (apply-times f (- n 1) (f x)))))
+
+(define run
+  (lambda (n total)
+    (if (= n 0)
+        total
+        (let ((counter (make-counter n))
+              (add-both (compose (add n) (add 1))))
+          (counter)
+          (counter)
+          (run (- n 1) (+ total (- (apply-times add-both 10 (counter)) (apply-times (add n) 13 0))))))))
+
+(run 200000 0)
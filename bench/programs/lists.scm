@@ -0,0 +1,57 @@
+; List building with cons, car and cdr: ranges, reversal, appending, filtering
+; and counting over lists of a hundred thousand items.
+
+; (quote ()) reads as a list holding the empty list, so take the empty list
+; from the end of a one-item list instead
+(define nil (cdr (quote (0))))
+(define range
+  (lambda (n)
+    (letrec ((loop (lambda (i result)
+                     (if (= i 0)
+                         result
+                         (loop (- i 1) (cons i result))))))
+      (loop n nil))))
+
+(define reverse
+  (lambda (items)
+    (letrec ((loop (lambda (items result)
+                     (if (null? items)
+                         result
+                         (loop (cdr items) (cons (car items) result))))))
+      (loop items nil))))
+
+(define append
+  (lambda (front back)
+    (reverse-onto (reverse front) back)))
+
+(define reverse-onto
+  (lambda (items result)
+    (if (null? items)
+        result
+        (reverse-onto (cdr items) (cons (car items) result)))))
+
+(define keep-below
+  (lambda (items limit)
+    (reverse (reverse-onto-if items limit nil))))
+
+(define reverse-onto-if
+  (lambda (items limit result)
+    (if (null? items)
+        result
+        (reverse-onto-if (cdr items) limit
+                         (if (< (car items) limit) (cons (car items) result) result)))))
+
+(define count
+  (lambda (items total)
+    (if (null? items)
+        total
+        (count (cdr items) (+ total 1)))))
+
+(define churn
+  (lambda (n total)
+    (if (= n 0)
+        total
+        (let ((items (append (range 100000) (reverse (range 100000)))))
+          (churn (- n 1) (+ total (count (keep-below items 50000) 0)))))))
+
+(churn 10 0)
@@ -0,0 +1,18 @@
+; Nested letrec loops in tail position, with let and local variables several
+; frames up.
+(define count-pairs
+  (lambda (n)
+    (letrec ((outer
+              (lambda (i total)
+                (if (= i 0)
+                    total
+                    (let ((limit i))
+                      (letrec ((inner
+                                (lambda (j total)
+                                  (if (= j 0)
+                                      total
+                                      (inner (- j 1) (if (< j limit) (+ total 1) total))))))
+                        (outer (- i 1) (inner n total))))))))
+      (outer n 0))))
+
+(count-pairs 2000)
@@ -0,0 +1,16 @@
+; Takeuchi's function, repeated: deep non-tail recursion with three arguments.
+(define tak
+  (lambda (x y z)
+    (if (< y x)
+        (tak (tak (- x 1) y z)
+             (tak (- y 1) z x)
+             (tak (- z 1) x y))
+        z)))
+
+(define repeat
+  (lambda (n result)
+    (if (= n 0)
+        result
+        (repeat (- n 1) (tak 18 12 6)))))
+
+(repeat 40 0)
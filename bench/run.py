@@ -0,0 +1,228 @@
+#!/usr/bin/env python3
+"""Runs the Scheme programs in bench/programs with the interpreter and reports,
+for each one, the wall time, the instructions executed and the peak resident
+set size, each compared with the numbers stored in bench/baseline.json.
+
+The wall time is the best of several runs. The peak resident set size is
+taken by bench/peak, which "make macrobench" builds along with the
+interpreter. Instructions are counted with
+"perf stat" when perf is installed and allowed to count, and shown as n/a
+otherwise. A program's output is also compared with the baseline, and the
+script exits with status 1 if any output differs, since a faster interpreter
+that gets the wrong answer is no improvement. Unless particular programs are
+named, it then checks that memory use does not grow with the number of
+trivial top-level forms read, from a file or through a pipe, and exits with
+status 1 if it does.
+
+Usage: bench/run.py [--interpreter PATH] [--runs N] [--update] [PROGRAM ...]
+
+With --update, the numbers measured replace the ones stored in the baseline.
+The baseline is only meaningful on the machine it was recorded on, so record
+one before making a change and compare after it.
+"""
+
+import argparse
+import hashlib
+import json
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+BENCH_DIR = os.path.dirname(os.path.abspath(__file__))
+PROGRAM_DIR = os.path.join(BENCH_DIR, "programs")
+BASELINE_PATH = os.path.join(BENCH_DIR, "baseline.json")
+PEAK_PATH = os.path.join(BENCH_DIR, "peak")
+
+# how many forms the generated program of top-level defines has
+DEFINE_COUNT = 100000
+
+
+def generate_defines(path):
+    """Writes a program of many top-level defines of functions and quoted data,
+    with calls to functions defined earlier, as a large generated file would be."""
+    with open(path, "w") as file:
+        file.write("; Generated by bench/run.py: a large file of top-level defines.\n")
+        for i in range(DEFINE_COUNT):
+            file.write("(define f%d (lambda (x) (+ x %d)))\n" % (i, i % 1000))
+            file.write("(define d%d (quote (%d %d.5 \"item %d\" #t (nested list))))\n" % (i, i, i % 97, i))
+            if i > 0 and i % 100 == 0:
+                file.write("(define v%d (f%d (car d%d)))\n" % (i, i - 1, i - 100))
+        file.write("(f%d (car d0))\n" % (DEFINE_COUNT - 1))
+
+
+# programs written by the runner rather than stored in bench/programs
+GENERATED = {"defines": generate_defines}
+
+# top-level forms repeated to check that memory use does not grow with the number of forms read, and how many of
+# each to compare; in the last, a closure is live while garbage is collected, so its code is marked as still needed
+TRIVIAL_FORMS = ["(+ %d 2)", "(quote (%d a b (c d) \"text\"))", "((lambda (x) (+ x %d)) 1)",
+                 "((lambda (x) (churn 100 (quote (%d a b (c d) \"text\")))) 1)"]
+FEW_FORMS = 100000
+MANY_FORMS = 400000
+
+# definitions written before the repeated forms, for them to use
+FORMS_PRELUDE = "(define churn (lambda (n keep) (if (= n 0) keep (begin (cons n n) (churn (- n 1) keep)))))\n"
+
+# how much the peak resident set size may grow, in kilobytes, as more forms are read
+MEMORY_SLACK_KB = 4096
+
+
+def find_programs(names, scratch):
+    """Returns (name, path) for each program to run: the ones named, or all of
+    them, generating those that are generated into the scratch directory."""
+    programs = {}
+    for entry in sorted(os.listdir(PROGRAM_DIR)):
+        if entry.endswith(".scm"):
+            programs[entry[:-4]] = os.path.join(PROGRAM_DIR, entry)
+    for name in GENERATED:
+        programs[name] = os.path.join(scratch, name + ".scm")
+    for name in names:
+        if name not in programs:
+            sys.exit("Unknown program %s; the programs are %s" % (name, ", ".join(sorted(programs))))
+    selected = sorted(names or programs)
+    for name in selected:
+        if name in GENERATED:
+            GENERATED[name](programs[name])
+    return [(name, programs[name]) for name in selected]
+
+
+def run_once(interpreter, path, piped=False):
+    """Runs the program once, given its path or, if piped, on stdin, and returns
+    its wall time in seconds, peak resident set size in kilobytes and output."""
+    with tempfile.TemporaryFile() as output, open(path, "rb") as source:
+        start = time.perf_counter()
+        process = subprocess.run([PEAK_PATH, interpreter] + ([] if piped else [path]), stdin=source if piped else None,
+                                 stdout=output, stderr=subprocess.PIPE)
+        seconds = time.perf_counter() - start
+        output.seek(0)
+        text = output.read()
+    if process.returncode != 0:
+        sys.exit("%s exited with status %d:\n%s%s" % (path, process.returncode, text.decode(errors="replace"),
+                                                      process.stderr.decode(errors="replace")))
+    return seconds, int(process.stderr.split()[-1]), text
+
+
+def count_instructions(interpreter, path):
+    """Returns the number of user-space instructions the program executes, or
+    None if perf cannot count them here."""
+    if shutil.which("perf") is None:
+        return None
+    with tempfile.NamedTemporaryFile(mode="r") as report:
+        result = subprocess.run(["perf", "stat", "-x", ",", "-e", "instructions:u", "-o", report.name,
+                                 interpreter, path], stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+        if result.returncode != 0:
+            return None
+        for line in report:
+            fields = line.split(",")
+            if len(fields) > 2 and fields[2].startswith("instructions"):
+                return int(fields[0]) if fields[0].isdigit() else None
+    return None
+
+
+def measure(interpreter, path, runs):
+    """Returns the measurements of one program, as stored in the baseline."""
+    times = []
+    peak = 0
+    output = None
+    for _ in range(runs):
+        seconds, maxrss, text = run_once(interpreter, path)
+        times.append(seconds)
+        peak = max(peak, maxrss)
+        output = text
+    return {
+        "seconds": min(times),
+        "instructions": count_instructions(interpreter, path),
+        "maxrss_kb": peak,
+        "output_sha256": hashlib.sha256(output).hexdigest(),
+    }
+
+
+def check_memory(interpreter, scratch):
+    """Runs FEW_FORMS and then MANY_FORMS copies of each of TRIVIAL_FORMS, read
+    from a file and then through a pipe, and returns whether the peak resident
+    set size grew by no more than MEMORY_SLACK_KB. Nothing is kept of a form
+    once it has run, the input included, unless something still refers to it."""
+    flat = True
+    path = os.path.join(scratch, "forms.scm")
+    for form in TRIVIAL_FORMS:
+        for piped in (False, True):
+            peaks = []
+            for count in (FEW_FORMS, MANY_FORMS):
+                with open(path, "w") as file:
+                    file.write(FORMS_PRELUDE)
+                    for i in range(count):
+                        file.write(form % i + "\n")
+                peaks.append(run_once(interpreter, path, piped)[1])
+            growth = peaks[1] - peaks[0]
+            print("%-60s %-6s %+8d KB over %d more forms%s" % (
+                form % 0, "piped" if piped else "file", growth, MANY_FORMS - FEW_FORMS,
+                "" if growth <= MEMORY_SLACK_KB else ", which is too much"))
+            flat = flat and growth <= MEMORY_SLACK_KB
+    return flat
+
+
+def change(new, old):
+    """Formats the change from old to new as a percentage, or blank if either
+    is missing."""
+    if new is None or not old:
+        return ""
+    return "%+.1f%%" % ((new - old) * 100.0 / old)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Run the Scheme benchmark programs.")
+    parser.add_argument("programs", nargs="*", help="programs to run, by name (default: all)")
+    parser.add_argument("--interpreter", default=os.path.join(BENCH_DIR, "..", "interpreter"),
+                        help="interpreter to run (default: the one built by make)")
+    parser.add_argument("--runs", type=int, default=3, help="runs of each program to take the best time of")
+    parser.add_argument("--update", action="store_true", help="store the measurements as the new baseline")
+    args = parser.parse_args()
+
+    for program in (args.interpreter, PEAK_PATH):
+        if not os.access(program, os.X_OK):
+            sys.exit("Could not run %s; build it with make macrobench" % program)
+    baseline = {}
+    if os.path.exists(BASELINE_PATH):
+        with open(BASELINE_PATH) as file:
+            baseline = json.load(file)
+
+    results = {}
+    wrong = []
+    with tempfile.TemporaryDirectory() as scratch:
+        programs = find_programs(args.programs, scratch)
+        print("%-12s %9s %8s %15s %8s %10s %8s" % ("program", "seconds", "", "instructions", "", "peak KB", ""))
+        for name, path in programs:
+            result = measure(args.interpreter, path, max(args.runs, 1))
+            old = baseline.get(name, {})
+            results[name] = result
+            instructions = result["instructions"]
+            print("%-12s %9.3f %8s %15s %8s %10d %8s" % (
+                name,
+                result["seconds"], change(result["seconds"], old.get("seconds")),
+                "n/a" if instructions is None else "{:,}".format(instructions),
+                change(instructions, old.get("instructions")),
+                result["maxrss_kb"], change(result["maxrss_kb"], old.get("maxrss_kb"))))
+            if "output_sha256" in old and old["output_sha256"] != result["output_sha256"]:
+                wrong.append(name)
+        flat = args.programs or check_memory(args.interpreter, scratch)
+
+    if args.update:
+        baseline.update(results)
+        with open(BASELINE_PATH, "w") as file:
+            json.dump(baseline, file, indent=2, sort_keys=True)
+            file.write("\n")
+        print("Stored the baseline in %s" % os.path.relpath(BASELINE_PATH))
+    elif wrong:
+        print("Output differs from the baseline for %s" % ", ".join(wrong))
+        return 1
+    if not flat:
+        print("Memory use grows with the number of top-level forms read")
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
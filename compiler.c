@@ -0,0 +1,703 @@
+#include "value.h"
+#include "linkedlist.h"
+#include "talloc.h"
+#include "analyzer.h"
+#include "compiler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef _COMPILER_C
+#define _COMPILER_C
+
+// The compiler follows the checks the tree-walking evaluator made, in the same
+// order, so that a malformed form is reported exactly when evaluation reaches
+// it: whatever it emits for the well-formed part runs first, followed by an
+// OP_ERROR instruction in place of the rest.
+
+// A Builder collects the instructions, constants and functions of one Code
+// while it is being compiled.
+typedef struct Builder {
+    uint32_t *instructions;
+    int length;
+    int instructionCapacity;
+    Value **constants;
+    int constantCount;
+    int constantCapacity;
+    Code **functions;
+    int functionCount;
+    int functionCapacity;
+} Builder;
+
+void compileExpression(Builder *builder, Value *expr, bool tail);
+
+// grow
+// params: array - an array allocated with malloc, or NULL; capacity - a pointer to its capacity in elements; size - the size of an element
+// returns: the array, reallocated with twice the capacity
+void *grow(void *array, int *capacity, size_t size) {
+    *capacity = *capacity == 0 ? 16 : *capacity * 2;
+    array = realloc(array, *capacity * size);
+    if (array == NULL) {
+        printf("Memory error: out of memory\n");
+        exit(1);
+    }
+    return array;
+}
+
+// emitWord
+// params: builder - a pointer to a Builder; word - an instruction, or a word of data following one
+// returns: the position of the new word
+int emitWord(Builder *builder, uint32_t word) {
+    if (builder -> length == builder -> instructionCapacity) {
+        builder -> instructions = grow(builder -> instructions, &builder -> instructionCapacity, sizeof(uint32_t));
+    }
+    builder -> instructions[builder -> length] = word;
+    builder -> length++;
+    return builder -> length - 1;
+}
+
+// emit
+// params: builder - a pointer to a Builder; op - an opcode; operand - its operand
+// returns: the position of the new instruction
+int emit(Builder *builder, opcode op, int operand) {
+    return emitWord(builder, INSTRUCTION(op, operand));
+}
+
+// patch
+// params: builder - a pointer to a Builder; position - the position of a jump instruction
+// returns: Nothing
+// patch() makes the jump at position go to the next instruction to be emitted
+void patch(Builder *builder, int position) {
+    opcode op = OPCODE(builder -> instructions[position]);
+    builder -> instructions[position] = INSTRUCTION(op, builder -> length);
+}
+
+// addConstant
+// params: builder - a pointer to a Builder; value - a pointer to a Value
+// returns: the number of the new constant
+int addConstant(Builder *builder, Value *value) {
+    if (builder -> constantCount == builder -> constantCapacity) {
+        builder -> constants = grow(builder -> constants, &builder -> constantCapacity, sizeof(Value *));
+    }
+    builder -> constants[builder -> constantCount] = value;
+    builder -> constantCount++;
+    return builder -> constantCount - 1;
+}
+
+// addFunction
+// params: builder - a pointer to a Builder; code - a pointer to the compiled body of a lambda expression
+// returns: the number of the new function
+int addFunction(Builder *builder, Code *code) {
+    if (builder -> functionCount == builder -> functionCapacity) {
+        builder -> functions = grow(builder -> functions, &builder -> functionCapacity, sizeof(Code *));
+    }
+    builder -> functions[builder -> functionCount] = code;
+    builder -> functionCount++;
+    return builder -> functionCount - 1;
+}
+
+// finish
+// params: builder - a pointer to a Builder that has been compiled into; paramCount - the number of parameters; frameSize - the number of slots in a frame for a call
+// returns: a pointer to a new Code holding what was compiled
+// finish() copies everything into one block, registers the constants with the garbage collector, and frees the Builder's arrays
+Code *finish(Builder *builder, int paramCount, int frameSize) {
+    size_t constantsSize = builder -> constantCount * sizeof(Value *);
+    size_t functionsSize = builder -> functionCount * sizeof(Code *);
+    Code *code = malloc(sizeof(Code) + constantsSize + functionsSize + builder -> length * sizeof(uint32_t));
+    if (code == NULL) {
+        printf("Memory error: out of memory\n");
+        exit(1);
+    }
+    code -> constants = (Value **)(code + 1);
+    code -> functions = (Code **)((char *)code -> constants + constantsSize);
+    code -> instructions = (uint32_t *)((char *)code -> functions + functionsSize);
+
+    code -> length = builder -> length;
+    memcpy(code -> instructions, builder -> instructions, builder -> length * sizeof(uint32_t));
+    code -> constantCount = builder -> constantCount;
+    if (builder -> constantCount > 0) {
+        memcpy(code -> constants, builder -> constants, constantsSize);
+    }
+    code -> functionCount = builder -> functionCount;
+    if (builder -> functionCount > 0) {
+        memcpy(code -> functions, builder -> functions, functionsSize);
+    }
+    code -> paramCount = paramCount;
+    code -> frameSize = frameSize;
+    code -> captured = false;
+    code -> survived = -1;
+    code -> next = NULL;
+    gcAddConstants(code -> constants, code -> constantCount);
+
+    free(builder -> instructions);
+    free(builder -> constants);
+    free(builder -> functions);
+    return code;
+}
+
+// makeBuilder
+// returns: an empty Builder
+Builder makeBuilder() {
+    Builder builder = {NULL, 0, 0, NULL, 0, 0, NULL, 0, 0};
+    return builder;
+}
+
+// emitConstant
+// params: builder - a pointer to a Builder; value - a pointer to a Value
+// returns: Nothing
+// emitConstant() emits an instruction pushing value
+void emitConstant(Builder *builder, Value *value) {
+    emit(builder, OP_CONST, addConstant(builder, value));
+}
+
+// emitReturn
+// params: builder - a pointer to a Builder; tail - whether the value just pushed is in tail position
+// returns: Nothing
+void emitReturn(Builder *builder, bool tail) {
+    if (tail) {
+        emit(builder, OP_RETURN, 0);
+    }
+}
+
+// emitError
+// params: builder - a pointer to a Builder; message - the text of an evaluation error
+// returns: Nothing
+void emitError(Builder *builder, char *message) {
+    Value *text = gcAllocValue();
+    text -> type = STR_TYPE;
+    text -> str.chars = message;
+    text -> str.length = strlen(message);
+    emit(builder, OP_ERROR, addConstant(builder, text));
+}
+
+// compileSequence
+// params: builder - a pointer to a Builder; body - a pointer to a Value representing a non-empty list of expressions; tail - whether the last one is in tail position
+// returns: Nothing
+// compileSequence() emits code that evaluates each expression in body in turn, leaving only the last one's value
+void compileSequence(Builder *builder, Value *body, bool tail) {
+    while (typeOf(cdr(body)) != NULL_TYPE) {
+        compileExpression(builder, car(body), false);
+        emit(builder, OP_POP, 0);
+        body = cdr(body);
+    }
+    compileExpression(builder, car(body), tail);
+}
+
+// compileBody
+// params: body - a pointer to a Value representing the non-empty body of a lambda expression; paramCount - the number of parameters; frameSize - the number of slots in a frame for a call
+// returns: a pointer to the compiled body
+Code *compileBody(Value *body, int paramCount, int frameSize) {
+    Builder builder = makeBuilder();
+    compileSequence(&builder, body, true);
+    return finish(&builder, paramCount, frameSize);
+}
+
+// compileLocal
+// params: builder - a pointer to a Builder; variable - a pointer to a LOCAL_TYPE Value
+// returns: Nothing
+void compileLocal(Builder *builder, Value *variable) {
+    if (variable -> lr.next != NULL) {
+        emit(builder, OP_LOCAL_CHAIN, addConstant(builder, variable));
+    } else if (variable -> lr.depth == 0) {
+        emit(builder, OP_LOCAL0, variable -> lr.slot);
+    } else if (variable -> lr.depth == 1) {
+        emit(builder, OP_LOCAL1, variable -> lr.slot);
+    } else {
+        emit(builder, OP_LOCAL, variable -> lr.slot);
+        emitWord(builder, variable -> lr.depth);
+    }
+}
+
+// compileLambda
+// params: builder - a pointer to a Builder; args - a pointer to a Value representing lambda's args; frameSize - the number of slots in a frame for a call; tail - whether the lambda expression is in tail position
+// returns: Nothing
+// compileLambda() makes the same checks on the parameters as the evaluator did when creating a closure
+void compileLambda(Builder *builder, Value *args, int frameSize, bool tail) {
+    // if too few arguments are given for lambda, throw an error.
+    if (typeOf(args) == NULL_TYPE || typeOf(cdr(args)) == NULL_TYPE) {
+        emitError(builder, "incorrect number of args for lambda");
+        return;
+    }
+
+    Value *param = car(args);
+    int paramCount = 0;
+    bool noParams = false;
+    while (typeOf(param) != NULL_TYPE) {
+        if (typeOf(param) != CONS_TYPE) {
+            emitError(builder, "bad param formatting in lambda");
+            return;
+        } else if (typeOf(car(param)) != SYMBOL_TYPE && typeOf(car(param)) != NULL_TYPE) {
+            emitError(builder, "non-variable param in lambda");
+            return;
+        } else if (typeOf(car(param)) == NULL_TYPE) {
+            // a parameter list containing () binds no parameters
+            noParams = true;
+        } else {
+            Value *earlier = car(args);
+            while (earlier != param) {
+                if (typeOf(car(earlier)) == SYMBOL_TYPE && car(earlier) -> s == car(param) -> s) {
+                    emitError(builder, "duplicate identifier in lambda");
+                    return;
+                }
+                earlier = cdr(earlier);
+            }
+            paramCount++;
+        }
+        param = cdr(param);
+    }
+    if (noParams) {
+        paramCount = 0;
+    }
+
+    emit(builder, OP_CLOSURE, addFunction(builder, compileBody(cdr(args), paramCount, frameSize)));
+    emitReturn(builder, tail);
+}
+
+// compileLet
+// params: builder - a pointer to a Builder; args - a pointer to a Value representing the arguments of the let statement; frameSize - the number of slots in the new frame; tail - whether the let statement is in tail position
+// returns: Nothing
+// the initial values are evaluated in the current frame and bound one at a time, then the body is evaluated in the new frame
+void compileLet(Builder *builder, Value *args, int frameSize, bool tail) {
+    // if no arguments or body are provided for let, throw an error.
+    if (typeOf(args) == NULL_TYPE || typeOf(cdr(args)) == NULL_TYPE) {
+        emitError(builder, "incorrect number of args for let");
+        return;
+    }
+    emit(builder, OP_NEW_FRAME, frameSize);
+
+    // checks list of bindings to make sure it is a proper list; throws error if not
+    if (typeOf(car(args)) != CONS_TYPE && typeOf(car(args)) != NULL_TYPE) {
+        emitError(builder, "invalid let binding");
+        return;
+    }
+    Value *binding = car(args);
+    while (typeOf(binding) != NULL_TYPE) {
+        // a binding with no initial value is checked for only once the ones before it have been evaluated
+        if (typeOf(binding) != CONS_TYPE || typeOf(car(binding)) != CONS_TYPE || typeOf(cdr(car(binding))) != CONS_TYPE) {
+            emitError(builder, "invalid let binding");
+            return;
+        }
+        compileExpression(builder, car(cdr(car(binding))), false);
+        // lexical addressing resolves every symbol bound by let to a slot
+        if (typeOf(car(car(binding))) != LOCAL_TYPE) {
+            emitError(builder, "variable being bound must be of symbol type");
+            return;
+        }
+        emit(builder, OP_BIND, addConstant(builder, car(car(binding))));
+        binding = cdr(binding);
+    }
+
+    emit(builder, tail ? OP_ENTER_TAIL : OP_ENTER, 0);
+    compileSequence(builder, cdr(args), tail);
+    if (!tail) {
+        emit(builder, OP_LEAVE, 0);
+    }
+}
+
+// compileLetRec
+// params: builder - a pointer to a Builder; args - a pointer to a Value representing the arguments of the letrec statement; frameSize - the number of slots in the new frame; tail - whether the letrec statement is in tail position
+// returns: Nothing
+// every variable is bound to a placeholder before the initial values are evaluated in the new frame, and they only replace the placeholders once all of them have been evaluated
+void compileLetRec(Builder *builder, Value *args, int frameSize, bool tail) {
+    // ensure two arguments for list of local variables and letrec body
+    if (typeOf(args) == NULL_TYPE || typeOf(cdr(args)) == NULL_TYPE) {
+        emitError(builder, "incorrect number of args for letrec");
+        return;
+    }
+    emit(builder, OP_NEW_FRAME, frameSize);
+
+    // check valid formatting for the letrec statement's binding list
+    if (typeOf(car(args)) != CONS_TYPE && typeOf(car(args)) != NULL_TYPE) {
+        emitError(builder, "invalid binding format for letrec");
+        return;
+    }
+    Value *bindings = car(args);
+    int count = 0;
+    while (typeOf(bindings) != NULL_TYPE) {
+        if (typeOf(bindings) != CONS_TYPE || typeOf(car(bindings)) != CONS_TYPE) {
+            emitError(builder, "invalid binding format for letrec");
+            return;
+        } else if (typeOf(car(car(bindings))) != LOCAL_TYPE) {
+            emitError(builder, "variable being bound must be of symbol type");
+            return;
+        }
+        emitConstant(builder, UNSPECIFIED_VALUE);
+        emit(builder, OP_BIND, addConstant(builder, car(car(bindings))));
+        bindings = cdr(bindings);
+        count++;
+    }
+    emit(builder, tail ? OP_ENTER_TAIL : OP_ENTER, 0);
+
+    // evaluate each binding value, then store them from the last one back
+    int *slots = malloc((count + 1) * sizeof(int));
+    if (slots == NULL) {
+        printf("Memory error: out of memory\n");
+        exit(1);
+    }
+    bindings = car(args);
+    for (int i = 0; i < count; i++) {
+        if (typeOf(cdr(car(bindings))) != CONS_TYPE) {
+            emitError(builder, "invalid binding format for letrec");
+            free(slots);
+            return;
+        }
+        compileExpression(builder, car(cdr(car(bindings))), false);
+        slots[i] = car(car(bindings)) -> lr.slot;
+        bindings = cdr(bindings);
+    }
+    for (int i = count - 1; i >= 0; i--) {
+        emit(builder, OP_STORE_LOCAL0, slots[i]);
+    }
+    free(slots);
+
+    compileSequence(builder, cdr(args), tail);
+    if (!tail) {
+        emit(builder, OP_LEAVE, 0);
+    }
+}
+
+// compileIf
+// params: builder - a pointer to a Builder; args - a pointer to a Value representing the arguments of the if statement; tail - whether the if statement is in tail position
+// returns: Nothing
+void compileIf(Builder *builder, Value *args, bool tail) {
+    // if more or less than 3 args provided, throw an error.
+    if (typeOf(args) != CONS_TYPE || typeOf(cdr(args)) == NULL_TYPE || typeOf(cdr(cdr(args))) == NULL_TYPE || typeOf(cdr(cdr(cdr(args)))) != NULL_TYPE) {
+        emitError(builder, "incorrect number of args for if statement");
+        return;
+    }
+
+    compileExpression(builder, car(args), false);
+    int branch = emit(builder, OP_BRANCH_FALSE, 0);
+    compileExpression(builder, car(cdr(args)), tail);
+    if (tail) {
+        patch(builder, branch);
+        compileExpression(builder, car(cdr(cdr(args))), tail);
+    } else {
+        int jump = emit(builder, OP_JUMP, 0);
+        patch(builder, branch);
+        compileExpression(builder, car(cdr(cdr(args))), tail);
+        patch(builder, jump);
+    }
+}
+
+// compileAssignment
+// params: builder - a pointer to a Builder; args - a pointer to a Value representing the arguments of a define or set! statement; op - OP_DEFINE or OP_SET; countMessage, variableMessage - the errors for the wrong number of arguments and for a first argument that is not a variable; tail - whether the statement is in tail position
+// returns: Nothing
+void compileAssignment(Builder *builder, Value *args, opcode op, char *countMessage, char *variableMessage, bool tail) {
+    if (typeOf(args) == NULL_TYPE || typeOf(cdr(args)) == NULL_TYPE || typeOf(cdr(cdr(args))) != NULL_TYPE) {
+        emitError(builder, countMessage);
+        return;
+    } else if (typeOf(car(args)) != SYMBOL_TYPE && typeOf(car(args)) != LOCAL_TYPE) {
+        emitError(builder, variableMessage);
+        return;
+    }
+    compileExpression(builder, car(cdr(args)), false);
+    emit(builder, op, addConstant(builder, car(args)));
+    emitReturn(builder, tail);
+}
+
+// compileApplication
+// params: builder - a pointer to a Builder; expr - a pointer to a Value representing a function call; tail - whether the call is in tail position
+// returns: Nothing
+// the function is evaluated first, then the arguments from left to right
+void compileApplication(Builder *builder, Value *expr, bool tail) {
+    compileExpression(builder, car(expr), false);
+    int argCount = 0;
+    Value *arg = cdr(expr);
+    while (typeOf(arg) != NULL_TYPE) {
+        compileExpression(builder, car(arg), false);
+        argCount++;
+        arg = cdr(arg);
+    }
+    if (tail) {
+        // a call to a primitive function comes back, and then returns
+        emit(builder, OP_TAIL_CALL, argCount);
+        emit(builder, OP_RETURN, 0);
+    } else {
+        emit(builder, OP_CALL, argCount);
+    }
+}
+
+// compileForm
+// params: builder - a pointer to a Builder; expr - a pointer to a CONS_TYPE Value; tail - whether expr is in tail position
+// returns: Nothing
+void compileForm(Builder *builder, Value *expr, bool tail) {
+    Value *first = car(expr);
+    Value *args = cdr(expr);
+    if (typeOf(first) != SYMBOL_TYPE && typeOf(first) != CONS_TYPE && typeOf(first) != LOCAL_TYPE && typeOf(first) != SCOPE_TYPE) {
+        emitError(builder, "given type not a function");
+        return;
+    }
+
+    // lexical addressing has replaced the keywords of lambda, let and letrec, annotating them with a frame size
+    specialForm form = typeOf(first) == SCOPE_TYPE ? first -> sh.form : formOf(expr);
+    switch (form) {
+        case LAMBDA_FORM: {
+            compileLambda(builder, args, first -> sh.frameSize, tail);
+            break;
+        }
+        case LET_FORM: {
+            compileLet(builder, args, first -> sh.frameSize, tail);
+            break;
+        }
+        case LETREC_FORM: {
+            compileLetRec(builder, args, first -> sh.frameSize, tail);
+            break;
+        }
+        case IF_FORM: {
+            compileIf(builder, args, tail);
+            break;
+        }
+        case QUOTE_FORM: {
+            // if there are none or multiple args given to quote, throw an error.
+            if (typeOf(args) != CONS_TYPE || typeOf(cdr(args)) != NULL_TYPE) {
+                emitError(builder, "incorrect number of args for quote");
+            } else {
+                emitConstant(builder, car(args));
+                emitReturn(builder, tail);
+            }
+            break;
+        }
+        case DEFINE_FORM: {
+            compileAssignment(builder, args, OP_DEFINE, "incorrect number of args for define", "trying to define non-variable", tail);
+            break;
+        }
+        case SET_FORM: {
+            compileAssignment(builder, args, OP_SET, "incorrect number of args for set!", "first argument for set! must be a variable symbol", tail);
+            break;
+        }
+        case BEGIN_FORM: {
+            if (typeOf(args) == NULL_TYPE) {
+                // if no args, the result is a VOID_TYPE Value
+                emitConstant(builder, VOID_VALUE);
+                emitReturn(builder, tail);
+            } else {
+                compileSequence(builder, args, tail);
+            }
+            break;
+        }
+        default: {
+            compileApplication(builder, expr, tail);
+            break;
+        }
+    }
+}
+
+// compileExpression
+// params: builder - a pointer to a Builder; expr - a pointer to a Value representing an expression; tail - whether expr is in tail position
+// returns: Nothing
+// compileExpression() emits code that pushes the value of expr, or, in tail position, returns it
+void compileExpression(Builder *builder, Value *expr, bool tail) {
+    switch (typeOf(expr)) {
+        case INT_TYPE:
+        case DOUBLE_TYPE:
+        case STR_TYPE:
+        case BOOL_TYPE:
+        case VOID_TYPE: {
+            emitConstant(builder, expr);
+            break;
+        }
+        case SYMBOL_TYPE: {
+            emit(builder, OP_GLOBAL, addConstant(builder, expr));
+            break;
+        }
+        case LOCAL_TYPE: {
+            compileLocal(builder, expr);
+            break;
+        }
+        case CONS_TYPE: {
+            compileForm(builder, expr, tail);
+            return;
+        }
+        default: {
+            emitConstant(builder, NULL_VALUE);
+            break;
+        }
+    }
+    emitReturn(builder, tail);
+}
+
+// markSurvived
+// params: code - a pointer to the Code of a closure that a garbage collection has kept
+// returns: Nothing
+void markSurvived(Code *code) {
+    code -> survived = gcMajorCollections();
+}
+
+// compile
+// params: tree - a pointer to a Value representing one analyzed top-level form
+// returns: a pointer to code that evaluates the form in the global frame
+Code *compile(Value *tree) {
+    // closures over this code may be kept by any collection from now on, and releaseCode() needs to hear of them
+    gcClosureVisitor(markSurvived);
+    Builder builder = makeBuilder();
+    compileExpression(&builder, tree, true);
+    return finish(&builder, 0, 0);
+}
+
+// Functions that a closure was made over while their top-level form ran
+// cannot be freed with it, since the closure may still be reachable. They are
+// set aside until PENDING_LIMIT bytes of them have built up, and then garbage
+// is collected to sort them out. A major collection visits every reachable
+// closure, and a minor one every closure it promotes, which is every closure
+// reachable that is younger than the last major collection. So after a minor
+// collection, each closure still reachable has marked its code with the
+// number of the latest major collection, and a function whose code does not
+// carry that mark, nor that of any function inside it, can be freed. Marks
+// left by closures that have since died go stale at the next major
+// collection, so the functions kept are sorted again after each one.
+
+// how many bytes of functions are set aside before garbage is collected to sort them out
+#define PENDING_LIMIT (256 * 1024)
+
+// the functions set aside, and how many bytes of code they hold
+Code *pendingCode = NULL;
+size_t pendingBytes = 0;
+
+// the functions that were still needed when last sorted, and the number of major collections there had been then
+Code *keptCode = NULL;
+int keptCollections = 0;
+
+// codeBytes
+// params: code - a pointer to a Code
+// returns: the size of the block holding code and of those holding the functions inside it
+size_t codeBytes(Code *code) {
+    size_t bytes = sizeof(Code) + code -> constantCount * sizeof(Value *) + code -> functionCount * sizeof(Code *) +
+                   code -> length * sizeof(uint32_t);
+    for (int i = 0; i < code -> functionCount; i++) {
+        bytes = bytes + codeBytes(code -> functions[i]);
+    }
+    return bytes;
+}
+
+// anyCaptured
+// params: code - a pointer to a Code
+// returns: whether a closure has been made over code or a function inside it
+bool anyCaptured(Code *code) {
+    if (code -> captured) {
+        return true;
+    }
+    for (int i = 0; i < code -> functionCount; i++) {
+        if (anyCaptured(code -> functions[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// anySurvived
+// params: code - a pointer to a Code; collections - the number of major collections there have been
+// returns: whether a collection since the last major one, or that one, has kept a closure over code or a function
+// inside it
+bool anySurvived(Code *code, int collections) {
+    if (code -> survived == collections) {
+        return true;
+    }
+    for (int i = 0; i < code -> functionCount; i++) {
+        if (anySurvived(code -> functions[i], collections)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// freeCode
+// params: code - a pointer to a Code; unregister - whether to unregister the constants with the garbage collector
+// returns: Nothing
+// freeCode() frees code and the code of every function inside it, unregistering their constants in the reverse of the
+// order finish() registered them in
+void freeCode(Code *code, bool unregister) {
+    if (unregister) {
+        gcRemoveConstants(code -> constants);
+    }
+    for (int i = code -> functionCount - 1; i >= 0; i--) {
+        freeCode(code -> functions[i], unregister);
+    }
+    free(code);
+}
+
+// resetCode
+// params: None
+// returns: Nothing
+// resetCode() frees every function set aside or kept, whose closures and constants tfree() is about to free
+void resetCode() {
+    Code *lists[] = {pendingCode, keptCode};
+    for (int i = 0; i < 2; i++) {
+        while (lists[i] != NULL) {
+            Code *next = lists[i] -> next;
+            freeCode(lists[i], false);
+            lists[i] = next;
+        }
+    }
+    pendingCode = NULL;
+    pendingBytes = 0;
+    keptCode = NULL;
+    keptCollections = 0;
+}
+
+// sortCode
+// params: list - the address of a list of functions; collections - the number of major collections there have been
+// returns: Nothing
+// sortCode() moves each function on the list that a closure may still need onto the kept list, and frees the rest
+void sortCode(Code **list, int collections) {
+    Code *code = *list;
+    *list = NULL;
+    while (code != NULL) {
+        Code *next = code -> next;
+        if (anySurvived(code, collections)) {
+            code -> next = keptCode;
+            keptCode = code;
+        } else {
+            freeCode(code, true);
+        }
+        code = next;
+    }
+}
+
+// sortPending
+// params: None
+// returns: Nothing
+// sortPending() collects garbage, then keeps each function set aside that a closure may still need, and frees the
+// rest; if there has been a major collection since the functions kept were last sorted, they are sorted again too
+void sortPending() {
+    gcCollect();
+    int collections = gcMajorCollections();
+    if (collections != keptCollections) {
+        sortCode(&keptCode, collections);
+        keptCollections = collections;
+    }
+    sortCode(&pendingCode, collections);
+    pendingBytes = 0;
+}
+
+// releaseCode
+// params: code - a pointer to the Code of a top-level form that has run
+// returns: Nothing
+// The form never runs again, so its own code goes at once, and so does that of every function inside it that no
+// closure was made over. The rest are set aside in a list that starts with the newest, so that sortPending()
+// unregisters their constants roughly in the reverse of the order they were registered in.
+void releaseCode(Code *code) {
+    gcRemoveConstants(code -> constants);
+    for (int i = 0; i < code -> functionCount; i++) {
+        Code *function = code -> functions[i];
+        if (!anyCaptured(function)) {
+            freeCode(function, true);
+        } else {
+            if (pendingCode == NULL && keptCode == NULL) {
+                tfreeHook(resetCode);
+            }
+            function -> next = pendingCode;
+            pendingCode = function;
+            pendingBytes = pendingBytes + codeBytes(function);
+        }
+    }
+    free(code);
+
+    if (pendingBytes >= PENDING_LIMIT || (keptCode != NULL && gcMajorCollections() != keptCollections)) {
+        sortPending();
+    }
+}
+
+#endif
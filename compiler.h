@@ -0,0 +1,82 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "value.h"
+
+#ifndef _COMPILER
+#define _COMPILER
+
+// Instructions run by execute() in interpreter.c. The virtual machine keeps a
+// stack of Values (and Frames, while a let or a call is in progress), the
+// current frame, and a stack of calls to return to. Each instruction is one
+// 32-bit word holding the opcode in its low 8 bits and an operand above them.
+typedef enum {
+    OP_CONST,           // push constant number operand
+    OP_GLOBAL,          // push the value of the global variable named by constant number operand
+    OP_LOCAL0,          // push slot number operand of the current frame
+    OP_LOCAL1,          // push slot number operand of the current frame's parent
+    OP_LOCAL,           // push slot number operand of the frame as many levels up as the next word says
+    OP_LOCAL_CHAIN,     // push the value of the LOCAL_TYPE reference that is constant number operand, which a
+                        // define may not have bound yet
+    OP_POP,             // discard the value on top of the stack
+    OP_JUMP,            // continue at instruction number operand
+    OP_BRANCH_FALSE,    // pop a boolean, and continue at instruction number operand if it is false
+    OP_CLOSURE,         // push a closure over the current frame for function number operand
+    OP_CALL,            // call the function below the operand arguments on top of the stack
+    OP_TAIL_CALL,       // the same, in tail position: the function returns straight to the current caller
+    OP_RETURN,          // return the value on top of the stack to the caller
+    OP_NEW_FRAME,       // push a new frame of operand slots whose parent is the current frame
+    OP_BIND,            // pop a value into the frame on top of the stack, in the slot of the LOCAL_TYPE
+                        // constant number operand
+    OP_ENTER,           // pop a frame and make it the current frame, pushing the one it replaces
+    OP_ENTER_TAIL,      // pop a frame and make it the current frame
+    OP_LEAVE,           // pop a value and then a frame, make the frame current again, and push the value back
+    OP_STORE_LOCAL0,    // pop a value into slot number operand of the current frame
+    OP_DEFINE,          // pop a value and bind the variable that is constant number operand to it in the current
+                        // frame, then push void
+    OP_SET,             // pop a value and assign it to the variable that is constant number operand, then push void
+    OP_ERROR            // report the evaluation error whose message is constant number operand
+} opcode;
+
+#define OPCODE(instruction) ((instruction) & 0xff)
+#define OPERAND(instruction) ((int)((instruction) >> 8))
+#define INSTRUCTION(op, operand) ((uint32_t)(op) | (uint32_t)(operand) << 8)
+
+// Compiled code for a top-level form or a function body. functions holds the
+// code of the lambda expressions inside it, for OP_CLOSURE. Each Code is one
+// block allocated with malloc, holding its arrays too, and never moves; its
+// constants are registered with the garbage collector. OP_CLOSURE sets
+// captured on the Code it makes a closure over, and survived is set on the
+// Code of every closure the collector reports keeping, to the number of major
+// collections there have been (or -1 if none has been kept), so that
+// releaseCode() can tell which code a closure may still need. next links the
+// functions that releaseCode() has set aside.
+struct Code {
+    uint32_t *instructions;
+    int length;
+    Value **constants;
+    int constantCount;
+    struct Code **functions;
+    int functionCount;
+    int paramCount;
+    int frameSize;
+    bool captured;
+    int survived;
+    struct Code *next;
+};
+
+typedef struct Code Code;
+
+// Compiles one top-level form, as prepared by analyze(), into code that
+// evaluates it in the global frame and returns the result. Forms that are
+// malformed compile to instructions that report the error at the point where
+// evaluation would have found it.
+Code *compile(Value *tree);
+
+// Frees the code of a top-level form once it has run, along with the code of
+// every function inside it that no closure was made over. The functions that
+// closures were made over are set aside, and once enough have been, garbage
+// is collected to find out which of them a closure may still need. Those are
+// kept, and sorted again after each major collection; the rest are freed.
+void releaseCode(Code *code);
+
+#endif
@@ -3,11 +3,15 @@
 #include "linkedlist.h"
 #include "talloc.h"
 #include "parser.h"
+#include "analyzer.h"
+#include "compiler.h"
+#include "output.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <assert.h>
+#include <stdint.h>
 
 #ifndef _INTERPRETER
 #define _INTERPRETER
@@ -15,1085 +19,823 @@
 // define eval
 Value *eval(Value *, Frame *);
 
+// The global frame keeps its variables in an open-addressing hash table keyed
+// by interned symbol name, so that defining or looking one up takes constant
+// time however many there are. globalNames holds the names; the slot at the
+// same position in globalValues holds the Value. globalValues is an ordinary
+// Frame so that the garbage collector finds the Values, and interpret()
+// registers it as a root. The table is kept at most half full.
+char **globalNames = NULL;
+Frame *globalValues = NULL;
+int globalCount = 0;
+
+/*
+findGlobal
+params: name - an interned symbol name
+returns: the position of name in the global table, or of the empty entry where it would go
+*/
+int findGlobal(char *name) {
+    int mask = globalValues -> size - 1;
+    // interned names are distinct, aligned addresses, so the address itself makes a good hash
+    uintptr_t hash = (uintptr_t)name >> 4;
+    int index = (hash ^ (hash >> 16)) & mask;
+    while (globalNames[index] != NULL && globalNames[index] != name) {
+        index = (index + 1) & mask;
+    }
+    return index;
+}
+
+/*
+resetGlobals
+params: None
+returns: nothing
+resetGlobals() empties the global table, whose names and Values tfree() is about to free.
+*/
+void resetGlobals() {
+    globalNames = NULL;
+    globalValues = NULL;
+    globalCount = 0;
+}
+
 /*
-* reverseTopLevel
-* params: linkedList - a pointer to a Value representing a linked list
-* returns: a pointer to a Value representing the same linked list with its top level elements in reverse order
+growGlobals
+params: None
+returns: nothing
+growGlobals() creates the global table, or moves its contents into one twice the size.
+Creating the table registers resetGlobals() with tfreeHook().
 */
-Value *reverseTopLevel(Value *linkedList) {
-    Value *previous = makeNull();
-    Value *current = linkedList;
-    Value *next = cdr(linkedList);
-    while (next->type != NULL_TYPE) {
-        current->c.cdr = previous;
-        previous = current;
-        current = next;
-        next = cdr(next);
+void growGlobals() {
+    char **oldNames = globalNames;
+    Frame *oldValues = globalValues;
+    int capacity = oldValues == NULL ? 64 : oldValues -> size * 2;
+    if (oldValues == NULL) {
+        tfreeHook(resetGlobals);
+    }
+
+    globalNames = talloc(capacity * sizeof(char *));
+    memset(globalNames, 0, capacity * sizeof(char *));
+    globalValues = gcAllocFrame(capacity);
+    globalValues -> parent = NULL;
+    if (oldValues != NULL) {
+        for (int i = 0; i < oldValues -> size; i++) {
+            if (oldNames[i] != NULL) {
+                int index = findGlobal(oldNames[i]);
+                globalNames[index] = oldNames[i];
+                globalValues -> slots[index] = oldValues -> slots[i];
+            }
+        }
     }
-    current->c.cdr = previous;
-    return current;
 }
 
 /*
 primitivePlus
-params: args - a pointer to a Value representing a linked list of arguments
+params: argc - the number of arguments; argv - a pointer to the first of argc pointers to Values
 returns: a pointer to a Value containing an integer or double that equals the sum of the arguments
 primitivePlus() throws an error if it encounters a non real-number argument.
 If no arguments are provided, primitivePlus returns a pointer to a Value containing 0.
 */
-Value *primitivePlus(Value *args) {
-   // Checks if no arguments were provided, and if so returns a pointer to an integer-type Value containing 0
-    if (args -> type == NULL_TYPE) {
-    Value *result = talloc(sizeof(Value));
-    result -> type = INT_TYPE;
-    result -> i = 0;
-    }
-   
-   Value *current = args;
+Value *primitivePlus(int argc, Value **argv) {
    Value *currentValue;
    int sumAsInt = 0;
    double sumAsDouble = 0;
    bool allInts = true;
-   while (current -> type != NULL_TYPE) {
-        currentValue = car(current);
-        if (currentValue -> type != INT_TYPE && currentValue -> type != DOUBLE_TYPE) {
+   for (int i = 0; i < argc; i++) {
+        currentValue = argv[i];
+        if (typeOf(currentValue) != INT_TYPE && typeOf(currentValue) != DOUBLE_TYPE) {
             printf("Evaluation error: attempting to sum non real-number arguments\n");
             texit(0);
         // If a double type seen in the arguments, switches sum to be stored as a double
-        } else if (currentValue -> type == DOUBLE_TYPE && allInts) {
+        } else if (typeOf(currentValue) == DOUBLE_TYPE && allInts) {
             sumAsDouble = sumAsInt + currentValue -> d;
             allInts = false;      
         } else if (allInts) {
-            sumAsInt = sumAsInt + currentValue -> i;
+            sumAsInt = sumAsInt + intValue(currentValue);
         } else {
-            if (currentValue -> type == INT_TYPE) {
-                sumAsDouble = sumAsDouble + currentValue -> i;
+            if (typeOf(currentValue) == INT_TYPE) {
+                sumAsDouble = sumAsDouble + intValue(currentValue);
             } else {
                 sumAsDouble = sumAsDouble + currentValue -> d;
             }
         }
-        current = cdr(current);
     }
 
     // make sure result is of the proper type and has its data stored in the proper locations
-    Value *result = talloc(sizeof(Value));
     if (allInts) {
-        result -> type = INT_TYPE;
-        result -> i = sumAsInt;
-    } else {
-        result -> type = DOUBLE_TYPE;
-        result -> d = sumAsDouble;
+        return makeInt(sumAsInt);
     }
-
+    Value *result = gcAllocValue();
+    result -> type = DOUBLE_TYPE;
+    result -> d = sumAsDouble;
     return result;
 }
 
 /*
 * primitiveMinus
-* params: args - a pointer to a Value representing a linked list of arguments
+* params: argc - the number of arguments; argv - a pointer to the first of argc pointers to Values
 * returns: a pointer to a Value containing an integer or double that equals the difference of the arguments
 * primitiveMinus() throws an error if it encounters a non real-number argument.
 * If no arguments are provided, primitiveMinus() returns a pointer to a Value containing 0.
 */
-Value *primitiveMinus(Value *args) {
-    if (args -> type == NULL_TYPE) {
+Value *primitiveMinus(int argc, Value **argv) {
+    if (argc == 0) {
         // if no args, return Value containing 0
-        Value *returnValue = talloc(sizeof(Value));
-        returnValue -> type = INT_TYPE;
-        returnValue -> i = 0;
-        return returnValue;
+        return makeInt(0);
     } else {
-        Value *current = args;
-        Value *currentValue = car(current);
+        Value *currentValue = argv[0];
         int differenceAsInt = 0;
         double differenceAsDouble = 0;
         // boolean to keep track of whether to return integer or double result
         bool allInts = true;
 
         // re-initialize difference as the number in the initial arg for proper behavior
-        if (currentValue -> type != INT_TYPE && currentValue -> type != DOUBLE_TYPE) {
+        if (typeOf(currentValue) != INT_TYPE && typeOf(currentValue) != DOUBLE_TYPE) {
             // throw error if initial arg does not contain a valid number
             printf("Evaluation error: attempting to subtract non real-number arguments\n");
             texit(0);
-        } else if (currentValue -> type == DOUBLE_TYPE) {
+        } else if (typeOf(currentValue) == DOUBLE_TYPE) {
             differenceAsDouble = currentValue -> d;
             allInts = false;
         } else {
-            differenceAsInt = currentValue -> i;
+            differenceAsInt = intValue(currentValue);
         }
-        current = cdr(current);
 
         // calculate the difference of the args, throws an error if an arg is not a valid number
-        while (current -> type != NULL_TYPE) {
-            currentValue = car(current);
-            if (currentValue -> type != INT_TYPE && currentValue -> type != DOUBLE_TYPE) {
+        for (int i = 1; i < argc; i++) {
+            currentValue = argv[i];
+            if (typeOf(currentValue) != INT_TYPE && typeOf(currentValue) != DOUBLE_TYPE) {
                 printf("Evaluation error: attempting to subtract non real-number arguments\n");
                 texit(0);
-            } else if (currentValue -> type == DOUBLE_TYPE && allInts) {
+            } else if (typeOf(currentValue) == DOUBLE_TYPE && allInts) {
                 differenceAsDouble = differenceAsInt - (currentValue -> d);
                 allInts = false;
             } else if (allInts) {
-                differenceAsInt = differenceAsInt - (currentValue -> i);
+                differenceAsInt = differenceAsInt - intValue(currentValue);
             } else {
-                if (currentValue -> type == DOUBLE_TYPE) {
+                if (typeOf(currentValue) == DOUBLE_TYPE) {
                     differenceAsDouble = differenceAsDouble - (currentValue -> d);
                 } else {
-                    differenceAsDouble = differenceAsDouble - (currentValue -> i);
+                    differenceAsDouble = differenceAsDouble - intValue(currentValue);
                 }
             }
-            current = cdr(current);
         }
 
         // depending on value of allInts, create and return either an integer or double result
-        Value *result = talloc(sizeof(Value));
         if (allInts) {
-            result -> type = INT_TYPE;
-            result -> i = differenceAsInt;
-        } else {
-            result -> type = DOUBLE_TYPE;
-            result -> d = differenceAsDouble;
+            return makeInt(differenceAsInt);
         }
-
+        Value *result = gcAllocValue();
+        result -> type = DOUBLE_TYPE;
+        result -> d = differenceAsDouble;
         return result;
     }
 }
 
 /*
-* primitiveEquals
-* params: args - a pointer to a Value representing a linked list of arguments
-* returns: a pointer to a BOOL_TYPE Value whose value depends on whether the given arguments are equal
+* checkComparable
+* params: argv - a pointer to two pointers to Values
+* returns: nothing
+* checkComparable() throws an error if either argument is not a number. All three comparison primitives report it as a failure of =.
 */
-Value *primitiveEquals(Value *args) {
-    if (args -> type == NULL_TYPE || cdr(args) -> type == NULL_TYPE || cdr(cdr(args)) -> type != NULL_TYPE) {
-        // throw an error if the list of arguments does not contain exactly two arguments
-        printf("Evaluation error: incorrect number of arguments for =\n");
-        texit(0);
-    } else if ((car(args) -> type != INT_TYPE && car(args) -> type != DOUBLE_TYPE) ||
-                (car(cdr(args)) -> type != INT_TYPE && car(cdr(args)) -> type != DOUBLE_TYPE)
-    ) {
-        // throw an error if at least one of the args is not a valid number
+void checkComparable(Value **argv) {
+    if ((typeOf(argv[0]) != INT_TYPE && typeOf(argv[0]) != DOUBLE_TYPE) ||
+        (typeOf(argv[1]) != INT_TYPE && typeOf(argv[1]) != DOUBLE_TYPE)) {
         printf("Evaluation error: cannot compare a non-number using =\n");
         texit(0);
-    } else {
-        Value *result = talloc(sizeof(Value));
-        result -> type = BOOL_TYPE;
+    }
+}
 
-        // account for each possible combination of arg types when determining result
-        if (car(args) -> type == INT_TYPE) {
-            if (car(cdr(args)) -> type == INT_TYPE) {
-                if (car(args) -> i == car(cdr(args)) -> i) {
-                    result -> i = 1;
-                } else {
-                    result -> i = 0;
-                }
-            } else {
-                if (car(args) -> i == car(cdr(args)) -> d) {
-                    result -> i = 1;
-                } else {
-                    result -> i = 0;
-                }
-            }
-        } else {
-            if (car(cdr(args)) -> type == INT_TYPE) {
-                if (car(args) -> d == car(cdr(args)) -> i) {
-                    result -> i = 1;
-                } else {
-                    result -> i = 0;
-                }
-            } else {
-                if (car(args) -> d == car(cdr(args)) -> d) {
-                    result -> i = 1;
-                } else {
-                    result -> i = 0;
-                }
-            }
-        }
+/*
+* asDouble
+* params: number - a pointer to an INT_TYPE or DOUBLE_TYPE Value
+* returns: the number as a double
+*/
+double asDouble(Value *number) {
+    if (typeOf(number) == INT_TYPE) {
+        return intValue(number);
+    }
+    return number -> d;
+}
 
-        return result;
+/*
+* primitiveEquals
+* params: argc - the number of arguments, which is 2; argv - a pointer to the arguments
+* returns: a pointer to a BOOL_TYPE Value whose value depends on whether the given arguments are equal
+*/
+Value *primitiveEquals(int argc, Value **argv) {
+    (void)argc;
+    checkComparable(argv);
+    if (typeOf(argv[0]) == INT_TYPE && typeOf(argv[1]) == INT_TYPE) {
+        return makeBool(intValue(argv[0]) == intValue(argv[1]));
     }
-    // extra return to prevent compiler warning
-    return makeNull();
+    return makeBool(asDouble(argv[0]) == asDouble(argv[1]));
 }
 
 /*
 * primitiveLessThan
-* params: args - a pointer to a Value representing a linked list of arguments
+* params: argc - the number of arguments, which is 2; argv - a pointer to the arguments
 * returns: a pointer to a BOOL_TYPE Value whose value depends on whether the first argument is less than the second
 */
-Value *primitiveLessThan(Value *args) {
-    if (args -> type == NULL_TYPE || cdr(args) -> type == NULL_TYPE || cdr(cdr(args)) -> type != NULL_TYPE) {
-        // if list of args does not contain exactly two items, throw an error
-        printf("Evaluation error: incorrect number of arguments for =\n");
-        texit(0);
-    } else if ((car(args) -> type != INT_TYPE && car(args) -> type != DOUBLE_TYPE) ||
-                (car(cdr(args)) -> type != INT_TYPE && car(cdr(args)) -> type != DOUBLE_TYPE)
-    ) {
-        // throw an error if at least one of the args is not a valid number
-        printf("Evaluation error: cannot compare a non-number using =\n");
-        texit(0);
-    } else {
-        Value *result = talloc(sizeof(Value));
-        result -> type = BOOL_TYPE;
-
-        // account for each possible combination of arg types while determining result
-        if (car(args) -> type == INT_TYPE) {
-            if (car(cdr(args)) -> type == INT_TYPE) {
-                if (car(args) -> i < car(cdr(args)) -> i) {
-                    result -> i = 1;
-                } else {
-                    result -> i = 0;
-                }
-            } else {
-                if (car(args) -> i < car(cdr(args)) -> d) {
-                    result -> i = 1;
-                } else {
-                    result -> i = 0;
-                }
-            }
-        } else {
-            if (car(cdr(args)) -> type == INT_TYPE) {
-                if (car(args) -> d < car(cdr(args)) -> i) {
-                    result -> i = 1;
-                } else {
-                    result -> i = 0;
-                }
-            } else {
-                if (car(args) -> d < car(cdr(args)) -> d) {
-                    result -> i = 1;
-                } else {
-                    result -> i = 0;
-                }
-            }
-        }
-
-        return result;
+Value *primitiveLessThan(int argc, Value **argv) {
+    (void)argc;
+    checkComparable(argv);
+    if (typeOf(argv[0]) == INT_TYPE && typeOf(argv[1]) == INT_TYPE) {
+        return makeBool(intValue(argv[0]) < intValue(argv[1]));
     }
-    // extra return to prevent compiler warning
-    return makeNull();
+    return makeBool(asDouble(argv[0]) < asDouble(argv[1]));
 }
 
 /*
 * primitiveGreaterThan
-* params: args - a pointer to a Value representing a linked list of arguments
+* params: argc - the number of arguments, which is 2; argv - a pointer to the arguments
 * returns: a pointer to a BOOL_TYPE Value whose value depends on whether the first argument is greater than the second
 */
-Value *primitiveGreaterThan(Value *args) {
-    if (args -> type == NULL_TYPE || cdr(args) -> type == NULL_TYPE || cdr(cdr(args)) -> type != NULL_TYPE) {
-        // throw an error if list of arguments does not contain exactly two arguments
-        printf("Evaluation error: incorrect number of arguments for =\n");
-        texit(0);
-    } else if ((car(args) -> type != INT_TYPE && car(args) -> type != DOUBLE_TYPE) ||
-                (car(cdr(args)) -> type != INT_TYPE && car(cdr(args)) -> type != DOUBLE_TYPE)
-    ) {
-        // throw an error if at least one of the args is not a valid number
-        printf("Evaluation error: cannot compare a non-number using =\n");
-        texit(0);
-    } else {
-        Value *result = talloc(sizeof(Value));
-        result -> type = BOOL_TYPE;
-
-        // account for each possible combination of arg types while determining result
-        if (car(args) -> type == INT_TYPE) {
-            if (car(cdr(args)) -> type == INT_TYPE) {
-                if (car(args) -> i > car(cdr(args)) -> i) {
-                    result -> i = 1;
-                } else {
-                    result -> i = 0;
-                }
-            } else {
-                if (car(args) -> i > car(cdr(args)) -> d) {
-                    result -> i = 1;
-                } else {
-                    result -> i = 0;
-                }
-            }
-        } else {
-            if (car(cdr(args)) -> type == INT_TYPE) {
-                if (car(args) -> d > car(cdr(args)) -> i) {
-                    result -> i = 1;
-                } else {
-                    result -> i = 0;
-                }
-            } else {
-                if (car(args) -> d > car(cdr(args)) -> d) {
-                    result -> i = 1;
-                } else {
-                    result -> i = 0;
-                }
-            }
-        }
-
-        return result;
+Value *primitiveGreaterThan(int argc, Value **argv) {
+    (void)argc;
+    checkComparable(argv);
+    if (typeOf(argv[0]) == INT_TYPE && typeOf(argv[1]) == INT_TYPE) {
+        return makeBool(intValue(argv[0]) > intValue(argv[1]));
     }
-    // extra return to prevent compiler warning
-    return makeNull();
+    return makeBool(asDouble(argv[0]) > asDouble(argv[1]));
 }
 
 /*
 primitiveNull
-params: args - a pointer to a Value representing a linked list of arguments
+params: argc - the number of arguments, which is 1; argv - a pointer to the argument
 returns: a pointer to a boolean-type Value
-primitiveNull() throws an error if greater or fewer than one argument is provided.
 The boolean-type Value returned by primitiveNull() will contain true if the argument was an empty list, and false in any other case.
-The 
 */
-Value *primitiveNull(Value *args) {
-    if (args -> type == NULL_TYPE || cdr(args) -> type != NULL_TYPE) {
-        printf("Evaluation error: incorrect number of args for 'null?'\n");
-        texit(0);
-    } else {
-        Value *arg = car(args);
-        Value *result = talloc(sizeof(Value));
-        result -> type = BOOL_TYPE;
-        if (args -> type == CONS_TYPE) {
-            if (isNull(arg)) {
-                result -> i = 1;
-            } else {
-                result -> i = 0;
-            }
-        } else {
-            result -> i = 0;
-        }
-        return result;
-    }
-    return makeNull();
+Value *primitiveNull(int argc, Value **argv) {
+    (void)argc;
+    return makeBool(isNull(argv[0]));
 }
 
 /*
 primitiveCar
-params: args - a pointer to a Value representing a linked list of arguments
+params: argc - the number of arguments, which is 1; argv - a pointer to the argument
 returns: a pointer to a Value representing the first item in a given list
-primitiveCar() will throw an error if it is given greater or fewer than one argument.
+primitiveCar() will throw an error if its argument is not a cons cell.
 */
-Value *primitiveCar(Value *args) {
-    if (args -> type == NULL_TYPE || cdr(args) -> type != NULL_TYPE) {
-        printf("Evaluation error: incorrect number of args for 'car'\n");
+Value *primitiveCar(int argc, Value **argv) {
+    (void)argc;
+    if (typeOf(argv[0]) != CONS_TYPE) {
+        printf("Evaluation error: argument to car is not a cons cell\n");
         texit(0);
-    } else {
-        Value *arg = car(args);
-        if (arg -> type != CONS_TYPE) {
-            printf("Evaluation error: argument to car is not a cons cell\n");
-            texit(0);
-        } else {
-            return car(arg);
-        }
     }
-    return makeNull();
+    return car(argv[0]);
 }
 
 /*
 primitiveCdr
-params: a pointer to a Value representing a linked list of arguments
+params: argc - the number of arguments, which is 1; argv - a pointer to the argument
 returns: a pointer to a Value representing everything but the first item in a given list
-primitiveCdr() will throw an error if it is given greater or fewer than one argument.
+primitiveCdr() will throw an error if its argument is not a cons cell.
 */
-Value *primitiveCdr(Value *args) {
-    if (args -> type == NULL_TYPE || cdr(args) -> type != NULL_TYPE) {
-        printf("Evaluation error: incorrect number of args for 'cdr'\n");
+Value *primitiveCdr(int argc, Value **argv) {
+    (void)argc;
+    if (typeOf(argv[0]) != CONS_TYPE) {
+        printf("Evaluation error: argument to cdr is not a cons cell\n");
         texit(0);
-    } else {
-        Value *arg = car(args);
-        if (arg -> type != CONS_TYPE) {
-            printf("Evaluation error: argument to cdr is not a cons cell\n");
-            texit(0);
-        } else {
-            return cdr(arg);
-        }
     }
-    return makeNull();
+    return cdr(argv[0]);
 }
 
 /*
 primitiveCons
-params: args - a pointer to a Value struct
+params: argc - the number of arguments, which is 2; argv - a pointer to the arguments
 returns: a pointer to a Value struct
-Returns a Cons cell of the two values contained within args. If args does not contain exactly two args, throw an error.
+Returns a Cons cell of the two arguments.
 */
-Value *primitiveCons(Value *args) {
-    // If args does not contain exactly two args, throw an error.
-    if (args -> type == NULL_TYPE || cdr(args) -> type == NULL_TYPE || cdr(cdr(args)) -> type != NULL_TYPE) {
-        printf("Evaluation error: incorrect number of args for 'cons'\n");
-        texit(0);
-
-    } else {
-        return cons(car(args), car(cdr(args)));
-    }
-    return makeNull();
+Value *primitiveCons(int argc, Value **argv) {
+    (void)argc;
+    return cons(argv[0], argv[1]);
 }
 
 /*
-bind
-params: name - a pointer to a string, function - a pointer to a function, frame - a pointer to a Frame struct
+addBinding
+params: name - an interned symbol name; value - a pointer to a Value
 returns: nothing
-bind() adds a definition to the global frame where the given name is the key and the function pointer is its value.
-*/
-void bind(char *name, Value *(*function)(struct Value *), Frame *frame) {
-    Value *functionValue = talloc(sizeof(Value));
-    functionValue -> type = PRIMITIVE_TYPE;
-    functionValue -> pf = function;
-    
-    Value *nameValue = talloc(sizeof(Value));
-    nameValue -> type = SYMBOL_TYPE;
-    nameValue -> s = name;
-
-    Value *binding = cons(nameValue, functionValue);
-    
-    frame -> bindings = cons(binding, frame -> bindings);
-}
-
-/*
-evalEach
-params: args - a pointer to a Value struct, frame - a pointer to a Frame struct
-returns: a Value struct containing the evaluated arguments to be passed into apply()
+addBinding() binds name to value in the global frame, and throws an error if name is already bound there.
 */
-Value *evalEach(Value *args, Frame *frame, bool needsReversal) {
-    Value *evaledArgs = makeNull();
-    Value *arg = args;
-    while (arg -> type != NULL_TYPE) {
-        evaledArgs = cons(eval(car(arg), frame), evaledArgs);
-        arg = cdr(arg);
+void addBinding(char *name, Value *value) {
+    if (globalValues == NULL || globalCount * 2 >= globalValues -> size) {
+        growGlobals();
     }
-    if (needsReversal && evaledArgs -> type != NULL_TYPE) {
-        //reverse the top-level list of arguments
-        evaledArgs = reverseTopLevel(evaledArgs);
+    int index = findGlobal(name);
+    // check for multiple bindings for a variable (not allowed)
+    if (globalNames[index] != NULL) {
+        printf("Evaluation error: local variable %s already bound\n", name);
+        texit(0);
     }
-    return evaledArgs;
+    globalNames[index] = name;
+    globalValues -> slots[index] = value;
+    gcWriteBarrier(globalValues);
+    globalCount++;
 }
 
 /*
-makeClosure
-params: environment - a pointer to a Frame; parameters - a pointer to a Value representing a linked list of parameters; functionBody - a pointer to a Value representing a function's body as a parse tree
-returns: a new Value of type CLOSURE_TYPE containing the information provided in the parameters
+bind
+params: name - a pointer to a string; function - a pointer to a primitive function; arity - the number of arguments function takes, or -1 for any number; arityError - the error to report when it is called with a different number
+returns: nothing
+bind() adds a definition to the global frame where the given name is the key and the function pointer is its value.
+Calls check the number of arguments against arity before function is called, so a primitive with a fixed number of arguments can index argv directly and ignore its argc.
 */
-Value *makeClosure(Frame *environment, Value *parameters, Value *functionBody) {
-    Value *closure = talloc(sizeof(Value));
-    closure -> type = CLOSURE_TYPE;
-    closure -> cl.paramNames = parameters;
-    closure -> cl.functionCode = functionBody;
-    closure -> cl.frame = environment;
-    return closure;
+void bind(char *name, Value *(*function)(int, struct Value **), int arity, char *arityError) {
+    assert(arity >= -1 && (arity == -1 || arityError != NULL));
+    Value *functionValue = gcAllocValue();
+    functionValue -> type = PRIMITIVE_TYPE;
+    functionValue -> pf.function = function;
+    functionValue -> pf.arity = arity;
+    functionValue -> pf.arityError = arityError;
+    addBinding(internSymbol(name, strlen(name)), functionValue);
 }
 
 /*
 makeFrame
-params: parent - a pointer to a Frame struct
+params: parent - a pointer to a Frame struct; size - the number of slots the Frame needs
 returns: newFrame - a pointer to a Frame struct
-Given a parent frame, allocates a null Frame and sets its parent to point to the parameter.
+Given a parent frame, allocates a Frame with no bindings and sets its parent to point to the parameter.
 */
-Frame *makeFrame(Frame *parent) {
-   Frame *newFrame = talloc(sizeof(Frame));
+Frame *makeFrame(Frame *parent, int size) {
+   Frame *newFrame = gcAllocFrame(size);
    newFrame -> parent = parent;
-   newFrame -> bindings = makeNull();
    return newFrame;
 }
 
 /*
-addBinding
-params: binding - a pointer to a Value representing a binding in dotted pair format; frame - a pointer to a Frame
-returns: nothing
-addBinding() adds the given binding to the given frame's list of bindings.
+frameAt
+params: frame - a pointer to a Frame; depth - a number of frames
+returns: a pointer to the Frame depth levels above frame
 */
-void addBinding(Value *binding, Frame *frame) {
-    Value *current = frame -> bindings;
-    // check for multiple bindings for a variable (not allowed)
-    while (current -> type != NULL_TYPE) {
-        if (!strcmp(car(car(current)) -> s, car(binding) -> s)) {
-            printf("Evaluation error: local variable %s already bound\n", car(binding) -> s);
-            texit(0);
-        }
-        current = cdr(current);
+Frame *frameAt(Frame *frame, int depth) {
+    for (int i = 0; i < depth; i++) {
+        frame = frame -> parent;
     }
+    return frame;
+}
 
-    // check to make sure variable to be bound is of symbol type
-    if (car(binding) -> type != SYMBOL_TYPE) {
-        printf("Evaluation error: variable being bound must be of symbol type\n");
+/*
+bindLocal
+params: variable - a pointer to a LOCAL_TYPE Value naming a slot in frame; value - a pointer to a Value; frame - a pointer to a Frame
+returns: nothing
+bindLocal() binds the variable's slot in frame to value, and throws an error if the slot is already bound.
+*/
+void bindLocal(Value *variable, Value *value, Frame *frame) {
+    if (frame -> slots[variable -> lr.slot] != NULL) {
+        printf("Evaluation error: local variable %s already bound\n", variable -> lr.symbol -> s);
         texit(0);
-
-    } else {
-        frame -> bindings = cons(binding, frame -> bindings);
     }
+    frame -> slots[variable -> lr.slot] = value;
+    gcWriteBarrier(frame);
 }
 
 /*
 * updateBinding
-* params: variable - a pointer to a Value specifying the variable whose binding should be changed; newValue - a pointer to a Value specifying the new value for the binding to be changed; frame - a pointer to a Frame in which to search for the binding
+* params: variable - a pointer to a LOCAL_TYPE or SYMBOL_TYPE Value specifying the variable whose binding should be changed; newValue - a pointer to a Value specifying the new value for the binding to be changed; frame - a pointer to the Frame the variable is referred to from
 * returns: nothing
-* updateBinding() recursively searches the given frame and its parents for the binding corresponding to the given variable; if found, the binding's value is updated to be newValue.
+* updateBinding() finds the binding corresponding to the given variable, trying each local variable it may refer to before the global frame; if found, the binding's value is updated to be newValue.
 * If a binding corresponding to the given variable is not found, updateBinding() will throw an error.
 */
 void updateBinding(Value *variable, Value *newValue, Frame *frame) {
-    Value *current = frame -> bindings;
-    bool updated = false;
-
-    // search bindings in current frame; if desired binding found, update its value
-    while (current -> type != NULL_TYPE) {
-        if (!strcmp(car(car(current)) -> s, variable -> s)) {
-            car(current) -> c.cdr = newValue;
-            updated = true;
-        }
-        current = cdr(current);
-    }
-
-    // if desired binding not found in current frame, recursively search parent frames
-    if (!updated) {
-        if (frame -> parent == NULL) {
-            // if desired binding has not been found and current frame does not have a parent, throw an error
-            printf("Evaluation error: variable %s never defined\n", variable -> s);
-            texit(0);
-        } else {
-            updateBinding(variable, newValue, frame -> parent);
+    // a local variable introduced by a define that has not run yet refers to the next one out
+    while (typeOf(variable) == LOCAL_TYPE) {
+        Frame *owner = frameAt(frame, variable -> lr.depth);
+        if (owner -> slots[variable -> lr.slot] != NULL) {
+            owner -> slots[variable -> lr.slot] = newValue;
+            gcWriteBarrier(owner);
+            return;
         }
+        variable = variable -> lr.next;
     }
-}
 
-/*
-apply
-params: evaledOperator - a pointer to a Value, that represents a closure corresponding to a function; evaledArgs - a pointer to a value representing a list of previously evaluated function arguments
-returns: the result of evaluating the body contained in the given closure, in the context of evaledArgs and the closure's environment
-apply() builds a new frame whose parent is the environment specified in the given closure, and adds bindings to it corresponding to each parameter/argument pair.
-apply() then evaluates the function body specified in the given closure in the context of the new frame, and returns the result.
-*/
-Value *apply(Value *evaledOperator, Value *evaledArgs) {
-    // if the given operator is not a function, throw an error.
-    if (evaledOperator -> type != CLOSURE_TYPE && evaledOperator -> type != PRIMITIVE_TYPE) {
-        printf("Evaluation error: non-function being called as function\n");
+    // otherwise look in the global frame; if desired binding has not been found, throw an error
+    int index = findGlobal(variable -> s);
+    if (globalNames[index] == NULL) {
+        printf("Evaluation error: variable %s never defined\n", variable -> s);
         texit(0);
-    
-    //
-    } else if (evaledOperator -> type == PRIMITIVE_TYPE) {
-        Value *result = (evaledOperator -> pf)(evaledArgs);
-        return result;
-        
-    // 
-    } else {
-        Frame *frame = makeFrame(evaledOperator -> cl.frame);
-        Value *param = evaledOperator -> cl.paramNames;
-        Value *arg = evaledArgs;
-        while (param -> type != NULL_TYPE) {
-            // if too few arguments are passed, throw an error.
-            if (arg -> type == NULL_TYPE) {
-                printf("Evaluation error: too few args passed to function\n");
-                texit(0);
-            }
-            Value *binding = cons(car(param), car(arg));
-            addBinding(binding, frame);
-            arg = cdr(arg);
-            param = cdr(param);
-        }
-
-        // if too many arguments are passed, throw an error.
-        if (arg -> type != NULL_TYPE) {
-            printf("Evaluation error: too many args passed to function\n");
-            texit(0);
-        }
-
-        Value *result;
-        Value *body = evaledOperator -> cl.functionCode;
-        while (body -> type != NULL_TYPE) {
-            result = eval(car(body), frame);
-            body = cdr(body);
-        }
-        // return the final evaluated expression in body
-        return result;
     }
-    // extra return to prevent compiler warning
-    return makeNull();
+    globalValues -> slots[index] = newValue;
+    gcWriteBarrier(globalValues);
 }
 
 /*
-evalDefine
-params: args - a pointer to a Value struct, frame - a pointer to a Frame struct
-returns: a Value struct of type VOID_TYPE
-Adds the bindings requested by args to the global frame.
+lookUpSymbol
+params: symbol - a pointer to a Value struct
+returns: a pointer to a Value struct
+Given a symbol, search the global frame for the symbol's assigned value. Lexical addressing has already resolved every local variable.
 */
-Value *evalDefine(Value *args, Frame *frame) {
-    // if no arguments or body are provided for define or too many arguments are provided, throw an error.
-    if (args -> type == NULL_TYPE || cdr(args) -> type == NULL_TYPE  || cdr(cdr(args)) -> type != NULL_TYPE) {
-        printf("Evaluation error: incorrect number of args for define\n");
-        texit(0);
-    // if the given variable for definition is not a symbol, throw an error.
-    } else if (car(args) -> type != SYMBOL_TYPE) {
-        printf("Evaluation error: trying to define non-variable\n");
+Value *lookUpSymbol(Value *symbol) {
+    int index = findGlobal(symbol -> s);
+    // if the symbol has not been defined, throw an error.
+    if (globalNames[index] == NULL) {
+        printf("Evaluation error: binding for symbol '%s' not defined in a frame\n", symbol -> s);
         texit(0);
     }
-    addBinding(cons(car(args), eval(car(cdr(args)), frame)), frame);
-
-    Value *returnValue = talloc(sizeof(Value));
-    returnValue -> type = VOID_TYPE;
-    return returnValue;
+    return globalValues -> slots[index];
 }
 
 /*
-evalLambda
-params: args - a pointer to a Value representing lambda's args; frame - a pointer to a Frame
-returns: a closure corresponding to the lambda expression being evaluated
-evalLambda() checks if the lambda expression's arguments are properly formatted, and if so, creates and returns a closure object corresponding to the expression.
-evalLambda() also performs general error checking, including the number of args, type of function parameters, and duplicate function parameters.
+lookUpLocal
+params: variable - a pointer to a LOCAL_TYPE Value, frame - a pointer to a Frame struct
+returns: a pointer to a Value struct
+Given a frame and a resolved local variable, returns the value in the variable's slot. If a define has not bound the slot yet, looks up whatever the variable refers to further out instead.
 */
-Value *evalLambda(Value *args, Frame *frame) {
-    // if too few arguments are given for lambda, throw an error.
-    if (args -> type == NULL_TYPE || cdr(args) -> type == NULL_TYPE) {
-        printf("Evaluation error: incorrect number of args for lambda\n");
-        texit(0);
-    }
-    
-    Value *params = car(args);
-    Value *param = params;
-    Value *visited = makeNull();
-    while (param -> type != NULL_TYPE) {
-        // if lambda's parameters are not formatted correctly, throw an error.
-        if (param -> type != CONS_TYPE) {
-            printf("Evaluation error: bad param formatting in lambda\n");
-            texit(0);
-        // if lambda's paramters are not a symbol, throw an error.
-        } else if (car(param) -> type != SYMBOL_TYPE && car(param) -> type != NULL_TYPE) {
-            printf("Evaluation error: non-variable param in lambda\n");
-            texit(0);
-        // if null param (indicating no parameters), set params equal to a NULL_TYPE Value.
-        } else if (car(param) -> type == NULL_TYPE) {
-            params = makeNull();
-            param = cdr(param);
-        } else {
-            Value *existing = visited;
-            while (existing -> type != NULL_TYPE) {
-                // if lambda's parameters contain duplicate identifiers, throw an error.
-                if (!strcmp(car(existing) -> s, car(param) -> s)) {
-                    printf("Evaluation error: duplicate identifier in lambda\n");
-                    texit(0);
-                }
-                existing = cdr(existing);
-            }
-            visited = cons(car(param), visited);
-            param = cdr(param);
+Value *lookUpLocal(Value *variable, Frame *frame) {
+    while (typeOf(variable) == LOCAL_TYPE) {
+        Value *value = frameAt(frame, variable -> lr.depth) -> slots[variable -> lr.slot];
+        if (value != NULL) {
+            return value;
         }
+        variable = variable -> lr.next;
     }
-    
-    return makeClosure(frame, params, cdr(args));
+    return lookUpSymbol(variable);
 }
 
-/*
-evalIf
-params: tree - a pointer to a Value struct, frame - a pointer to a Frame struct
-returns: a pointer to a Value struct
-Function is called in the case that an 'if' symbol is evaluated. Returns the second arg if the first arg evaluates to true and the third arg if false.
-*/
-Value *evalIf(Value *args, Frame *frame) {
-    // if more or less than 3 args provided, throw an error.
-    if (cdr(args) -> type == NULL_TYPE || cdr(cdr(args)) -> type == NULL_TYPE || cdr(cdr(cdr(args))) -> type != NULL_TYPE) {
-        printf("Evaluation error: incorrect number of args for if statement\n");
-        texit(0);
-    }
+// The virtual machine's stack of Values. While a let statement or a call is in
+// progress, the Frame it will return to is kept on the stack too. interpret()
+// registers the stack with the garbage collector, so every entry is a root.
+Value **stack = NULL;
+int stackTop = 0;
+int stackCapacity = 0;
 
-    Value *boolResult = eval(car(args), frame);
-    // if the first arg does not evaluate to a boolean, throw an error.
-    if (boolResult -> type != BOOL_TYPE) {
-        printf("Evaluation error: if statement predicate does not resolve to boolean\n");
-        texit(0);
+// The calls in progress, each with the code and position to return to
+typedef struct Return {
+    Code *code;
+    int pc;
+} Return;
 
-    } else if (boolResult -> i == 1) {
-        return eval(car(cdr(args)), frame);
-
-    } else {
-        return eval(car(cdr(cdr(args))), frame);
-    }
-    // extra return to prevent compiler warning
-    return makeNull();
-}
+Return *returns = NULL;
+int returnTop = 0;
+int returnCapacity = 0;
 
 /*
-evalLet
-params: args - a pointer to a Value representing the arguments of the let statement; frame - a pointer to a Frame
-returns: a pointer to a Value, that is the result of evaluating the body of the let statement within the proper Frame
-evalLet() creates a new Frame containing the let statement's bindings, then evaluates the let statement's body in the context of that Frame.
+resetMachine
+params: None
+returns: nothing
+resetMachine() frees the virtual machine's stacks, whose entries point at objects tfree() is about to free.
 */
-Value *evalLet(Value *args, Frame *frame) {
-    // if no arguments or body are provided for let, throw an error.
-    if (args -> type == NULL_TYPE || cdr(args) -> type == NULL_TYPE) {
-        printf("Evaluation error: incorrect number of args for let\n");
-        texit(0);
-
-    }
-    // create new frame in which to evaluate let
-    Frame *newFrame = makeFrame(frame);
-    
-    // checks list of bindings to make sure it is a proper list; throws error if not
-    if (car(args) -> type != CONS_TYPE && car(args) -> type != NULL_TYPE) {
-        printf("Evaluation error: invalid let binding\n");
-        texit(0);
-    }
-
-    // checks proper nested list formatting for list of bindings; throws error if bindings are incorrectly formatted
-    Value *binding = car(args);
-    while(binding -> type != NULL_TYPE) {
-        // check outer list format
-        if (binding -> type != CONS_TYPE) {
-            printf("Evaluation error: invalid let binding\n");
-            texit(0);
-
-        // check each binding itself
-        } else if (car(binding) -> type != CONS_TYPE) {
-            printf("Evaluation error: invalid let binding\n");
-            texit(0);
-
-        // adds binding to newFrame
-        } else {
-            addBinding(cons(car(car(binding)), eval(car(cdr(car(binding))), frame)), newFrame);
-            binding = cdr(binding);
-        }
-    }
-
-    // evaluates body of the let statement in the context of newFrame 
-    Value *result;
-    Value *body = cdr(args);
-    while (body -> type != NULL_TYPE) {
-        result = eval(car(body), newFrame);
-        body = cdr(body);
-    }
-    // return the final evaluated expression in body
-    return result;
+void resetMachine() {
+    free(stack);
+    stack = NULL;
+    stackTop = 0;
+    stackCapacity = 0;
+    free(returns);
+    returns = NULL;
+    returnTop = 0;
+    returnCapacity = 0;
 }
 
 /*
-* evalLetRec
-* params: args - a pointer to a Value representing a linked list of arguments; frame - a pointer to the Frame in which to evaluate the statement
-* returns: a pointer to a Value representing the result of evaluating the final s-expression in the body of the letrec statement
-* evalLetRec() ensures that the local variables created in letrec's new frame do not depend on each other.
-* Unlike evalLet(), evalLetRec() evaluates both the local variables and the body in the context of its new frame.
+push
+params: value - a pointer to a Value, or a Frame cast to one
+returns: nothing
+push() pushes value onto the virtual machine's stack, growing the stack if it is full.
+Creating the stack registers resetMachine() with tfreeHook().
 */
-Value *evalLetRec(Value *args, Frame *frame) {
-    // ensure two arguments for list of local variables and letrec body
-    if (args -> type == NULL_TYPE || cdr(args) -> type == NULL_TYPE) {
-        printf("Evaluation error: incorrect number of args for letrec\n");
-        texit(0);
-    }
-
-    // create new frame in which to evaluate new local variables/letrec body
-    Frame *newFrame = makeFrame(frame);
-
-    // check valid formatting for the letrec statement's binding list
-    if (car(args) -> type != CONS_TYPE && car(args) -> type != NULL_TYPE) {
-        printf("Evaluation error: invalid binding format for letrec\n");
-        texit(0);
-    }
-
-    // add bindings to the new frame; throw an error if bindings are improperly formatted
-    Value *bindings = car(args);
-    Value *placeholder;
-    while (bindings -> type != NULL_TYPE) {
-        if (bindings -> type != CONS_TYPE) {
-            printf("Evaluation error: invalid binding format for letrec\n");
-            texit(0);
-        } else if (car(bindings) -> type != CONS_TYPE) {
-            printf("Evaluation error: invalid binding format for letrec\n");
-            texit(0);
-        } else {
-            placeholder = talloc(sizeof(Value));
-            placeholder -> type = UNSPECIFIED_TYPE;
-            addBinding(cons(car(car(bindings)), placeholder), newFrame);
-            bindings = cdr(bindings);
+void push(Value *value) {
+    if (stackTop == stackCapacity) {
+        if (stackCapacity == 0) {
+            tfreeHook(resetMachine);
         }
-    }
-
-    // evaluate each binding value
-    Value *evaluated = makeNull();
-    bindings = car(args);
-    Value *evaledValue;
-    while (bindings -> type != NULL_TYPE) {
-        evaledValue = eval(car(cdr(car(bindings))), newFrame);
-        evaluated = cons(evaledValue, evaluated);
-        bindings = cdr(bindings);
-    }
-
-    // reverse the list of evaluated binding values for consistency between variable/value ordering
-    if (evaluated -> type != NULL_TYPE) {
-        evaluated = reverseTopLevel(evaluated);
-    }
-
-    // update each variable binding in the new frame to contain its corresponding evaluated value
-    bindings = car(args);
-    evaledValue = evaluated;
-    while (evaledValue -> type != NULL_TYPE) {
-        updateBinding(car(car(bindings)), car(evaledValue), newFrame);
-        bindings = cdr(bindings);
-        evaledValue = cdr(evaledValue);
-    }
-
-    // evaluate the body of the letrec statement and return the result of the final s-expression
-    Value *result;
-    Value *body = cdr(args);
-    while (body -> type != NULL_TYPE) {
-        result = eval(car(body), newFrame);
-        body = cdr(body);
-    }
-    return result;
-}
-
-/*
-* evalSetBang
-* params: args - a pointer to a Value representing a linked list of arguments; frame - a pointer to a Frame
-* returns: a pointer to a VOID_TYPE Value
-* evalSetBang() attempts to access the binding of the variable given as the first argument and replace its existing value with the new value given as the second argument.
-* If no binding for the variable given as the first argument exists, evalSetBang() throws an error.
-*/
-Value *evalSetBang(Value *args, Frame *frame) {
-    // check for exactly two args
-    if (args -> type == NULL_TYPE || cdr(args) -> type == NULL_TYPE || cdr(cdr(args)) -> type != NULL_TYPE) {
-        printf("Evaluation error: incorrect number of args for set!\n");
-        texit(0);
-    } else {
-        // ensure first arg is a variable (must be SYMBOL_TYPE)
-        if (car(args) -> type != SYMBOL_TYPE) {
-            printf("Evaluation error: first argument for set! must be a variable symbol\n");
-            texit(0);
-        } else {
-            // attempt to access the binding corresponding to the given variable and update its value
-            updateBinding(car(args), eval(car(cdr(args)), frame), frame);
-            Value *returnValue = talloc(sizeof(Value));
-            returnValue -> type = VOID_TYPE;
-            return returnValue;
+        stackCapacity = stackCapacity == 0 ? 1024 : stackCapacity * 2;
+        stack = realloc(stack, stackCapacity * sizeof(Value *));
+        if (stack == NULL) {
+            printf("Memory error: out of memory\n");
+            exit(1);
         }
     }
-    // extra return to prevent compiler warning
-    return makeNull();
+    stack[stackTop] = value;
+    stackTop++;
 }
 
 /*
-* evalBegin
-* params: args - a pointer to a Value representing a linked list of arguments; frame - a pointer to a Frame
-* returns: a pointer to a Value representing the result of evaluating the final s-expression in the body of the begin statement
-* evalBegin() evaluates each argument in the given list of arguments as an s-expression, and returns the result of the last one.
-* If there are no arguments, evalBegin() returns a VOID_TYPE Value.
+pushReturn
+params: code - a pointer to the Code making a call; pc - the position to continue from when the call returns
+returns: nothing
 */
-Value *evalBegin(Value *args, Frame *frame) {
-    if (args -> type == NULL_TYPE) {
-        // if no args, return VOID_TYPE Value
-        Value *returnValue = talloc(sizeof(Value));
-        returnValue -> type = VOID_TYPE;
-        return returnValue;
-    } else {
-        // evaluate each s-expression given in args and return the result of the final evaluation
-        Value *returnValue = talloc(sizeof(Value));
-        Value *arg = args;
-        while (arg -> type != NULL_TYPE) {
-            returnValue = eval(car(arg), frame);
-            arg = cdr(arg);
-        }
-        return returnValue;
-    }
+void pushReturn(Code *code, int pc) {
+    if (returnTop == returnCapacity) {
+        returnCapacity = returnCapacity == 0 ? 256 : returnCapacity * 2;
+        returns = realloc(returns, returnCapacity * sizeof(Return));
+        if (returns == NULL) {
+            printf("Memory error: out of memory\n");
+            exit(1);
+        }
+    }
+    returns[returnTop].code = code;
+    returns[returnTop].pc = pc;
+    returnTop++;
 }
 
 /*
-lookUpSymbol
-params: symbol - a pointer to a Value struct, frame - a pointer to a Frame struct
-returns: a pointer to a Value struct
-Given a frame and a symbol, traverse the frame searching for the symbol's assigned value.
+checkSpecified
+params: value - a pointer to the Value of a variable
+returns: value
+checkSpecified() throws an error if value is the placeholder letrec binds its variables to while their initial values are evaluated.
 */
-Value *lookUpSymbol(Value *symbol, Frame *frame) {
-    Value *currentBinding = frame -> bindings;
-    while (currentBinding -> type != NULL_TYPE) {
-        if (!strcmp(car(car(currentBinding)) -> s, symbol -> s)) {
-            return cdr(car(currentBinding));
-        } else {
-            currentBinding = cdr(currentBinding);
-        }
-    }
-
-    // if the symbol has not been defined, throw an error.
-    if (frame -> parent == NULL) {
-        printf("Evaluation error: binding for symbol '%s' not defined in a frame\n", symbol -> s);
+Value *checkSpecified(Value *value) {
+    if (value == UNSPECIFIED_VALUE) {
+        printf("Evaluation error: local variable depends on local variable in same frame\n");
         texit(0);
     }
-
-    return lookUpSymbol(symbol, frame -> parent);
+    return value;
 }
 
+// With GCC and Clang each instruction jumps straight to the next one's code
+// through a table of label addresses; elsewhere they go back round a switch.
+#ifdef __GNUC__
+#define TARGET(op) target_##op: case op:
+#define DISPATCH() instruction = code -> instructions[pc++]; goto *targets[OPCODE(instruction)]
+#else
+#define TARGET(op) case op:
+#define DISPATCH() goto next
+#endif
+
 /*
-eval
-params: tree - a pointer to a Value struct, frame - a pointer to a Frame struct
-returns: a pointer to a Value struct
-Given a pointer to a parse tree and a pointer to a frame, evaluate the parse tree in the context of the current frame.
+execute
+params: code - a pointer to compiled Code; frame - a pointer to the Frame to run it in
+returns: a pointer to the Value the code returns
+execute() runs code on the virtual machine until it returns. Calls to closures do not recurse in C: the caller's code, position and frame are saved on the virtual machine's stacks, and a tail call saves nothing, so tail calls run in constant space.
+Garbage is only collected when a function is called, while frame is kept on the stack.
 */
-Value *eval(Value *tree, Frame *frame) {
-    switch (tree->type)  {
-        case INT_TYPE: {
-            return tree;
-        }
-        case DOUBLE_TYPE: {
-            return tree;
-        }
-        case STR_TYPE: {
-            return tree;
-        }
-        case BOOL_TYPE: {
-            return tree;
-        }
-        case SYMBOL_TYPE: {
-            Value *result = lookUpSymbol(tree, frame);
-            if (result -> type == UNSPECIFIED_TYPE) {
-                printf("Evaluation error: local variable depends on local variable in same frame\n");
+Value *execute(Code *code, Frame *frame) {
+#ifdef __GNUC__
+    static void *targets[] = {
+        &&target_OP_CONST, &&target_OP_GLOBAL, &&target_OP_LOCAL0, &&target_OP_LOCAL1, &&target_OP_LOCAL,
+        &&target_OP_LOCAL_CHAIN, &&target_OP_POP, &&target_OP_JUMP, &&target_OP_BRANCH_FALSE, &&target_OP_CLOSURE,
+        &&target_OP_CALL, &&target_OP_TAIL_CALL, &&target_OP_RETURN, &&target_OP_NEW_FRAME, &&target_OP_BIND,
+        &&target_OP_ENTER, &&target_OP_ENTER_TAIL, &&target_OP_LEAVE, &&target_OP_STORE_LOCAL0, &&target_OP_DEFINE,
+        &&target_OP_SET, &&target_OP_ERROR
+    };
+#endif
+    int pc = 0;
+    int returnBase = returnTop;
+    uint32_t instruction;
+    Value *value;
+    int argCount;
+
+#ifndef __GNUC__
+next:
+#endif
+    instruction = code -> instructions[pc++];
+#ifdef __GNUC__
+    goto *targets[OPCODE(instruction)];
+#endif
+    switch (OPCODE(instruction)) {
+        TARGET(OP_CONST) {
+            push(code -> constants[OPERAND(instruction)]);
+            DISPATCH();
+        }
+        TARGET(OP_GLOBAL) {
+            push(checkSpecified(lookUpSymbol(code -> constants[OPERAND(instruction)])));
+            DISPATCH();
+        }
+        TARGET(OP_LOCAL0) {
+            push(checkSpecified(frame -> slots[OPERAND(instruction)]));
+            DISPATCH();
+        }
+        TARGET(OP_LOCAL1) {
+            push(checkSpecified(frame -> parent -> slots[OPERAND(instruction)]));
+            DISPATCH();
+        }
+        TARGET(OP_LOCAL) {
+            int depth = code -> instructions[pc++];
+            push(checkSpecified(frameAt(frame, depth) -> slots[OPERAND(instruction)]));
+            DISPATCH();
+        }
+        TARGET(OP_LOCAL_CHAIN) {
+            push(checkSpecified(lookUpLocal(code -> constants[OPERAND(instruction)], frame)));
+            DISPATCH();
+        }
+        TARGET(OP_POP) {
+            stackTop--;
+            DISPATCH();
+        }
+        TARGET(OP_JUMP) {
+            pc = OPERAND(instruction);
+            DISPATCH();
+        }
+        TARGET(OP_BRANCH_FALSE) {
+            value = stack[--stackTop];
+            if (value == FALSE_VALUE) {
+                pc = OPERAND(instruction);
+            } else if (value != TRUE_VALUE) {
+                // if the predicate does not evaluate to a boolean, throw an error.
+                printf("Evaluation error: if statement predicate does not resolve to boolean\n");
                 texit(0);
-                return makeNull();
-            } else {
-                return result;
             }
-        }  
-        case CONS_TYPE: {
-            Value *first = car(tree);
-            Value *args = cdr(tree);
-
-            if (first -> type != SYMBOL_TYPE && first -> type != CONS_TYPE) {
-                printf("Evaluation error: given type not a function\n");
-                texit(0);
-
-            } else if (!strcmp(first->s, "if")) {
-               return evalIf(args, frame);
-               
-            } else if (!strcmp(first->s, "let")) {
-                return evalLet(args, frame);
-
-            } else if (!strcmp(first->s, "quote")) {
-                // if there are none or multiple args given to quote, throw an error.
-                if (args -> type != CONS_TYPE || cdr(args) -> type != NULL_TYPE) {
-                    printf("Evaluation error: incorrect number of args for quote\n");
+            DISPATCH();
+        }
+        TARGET(OP_CLOSURE) {
+            value = gcAllocValue();
+            value -> type = CLOSURE_TYPE;
+            value -> cl.code = code -> functions[OPERAND(instruction)];
+            value -> cl.code -> captured = true;
+            value -> cl.frame = frame;
+            push(value);
+            DISPATCH();
+        }
+        TARGET(OP_CALL)
+        TARGET(OP_TAIL_CALL) {
+            // every call is a point where garbage may be collected
+            push((Value *)frame);
+            gcSafePoint();
+            frame = (Frame *)stack[--stackTop];
+
+            argCount = OPERAND(instruction);
+            value = stack[stackTop - argCount - 1];
+            if (typeOf(value) == CLOSURE_TYPE) {
+                Code *callee = value -> cl.code;
+                // if too few or too many arguments are passed, throw an error.
+                if (argCount < callee -> paramCount) {
+                    printf("Evaluation error: too few args passed to function\n");
+                    texit(0);
+                } else if (argCount > callee -> paramCount) {
+                    printf("Evaluation error: too many args passed to function\n");
                     texit(0);
-                } else {
-                    return car(args);
                 }
-            
-            } else if (!strcmp(first->s, "define")) { 
-                return evalDefine(args, frame);  
-
-            } else if (!strcmp(first->s, "lambda")) {
-                return evalLambda(args, frame);
-
-            } else if (!strcmp(first->s, "letrec")) {
-                return evalLetRec(args, frame);
-
-            } else if (!strcmp(first->s, "set!")) {
-                return evalSetBang(args, frame);
-
-            } else if (!strcmp(first->s, "begin")) {
-                return evalBegin(args, frame);
+                // the arguments go straight from the stack into the parameters' slots, without building a list
+                Frame *newFrame = makeFrame(value -> cl.frame, callee -> frameSize);
+                memcpy(newFrame -> slots, stack + stackTop - argCount, argCount * sizeof(Value *));
+                stackTop -= argCount + 1;
+                if (OPCODE(instruction) == OP_CALL) {
+                    push((Value *)frame);
+                    pushReturn(code, pc);
+                }
+                code = callee;
+                pc = 0;
+                frame = newFrame;
 
-            } else {
-                // if not special form, evaluate first and args, then try to apply the results as a function
-                Value *evaledOperator = eval(first, frame);
-                bool needsReversal = true;
-                if (!strcmp(first->s, "car") || !strcmp(first->s, "cdr")) {
-                    needsReversal = false;
+            } else if (typeOf(value) == PRIMITIVE_TYPE) {
+                if (value -> pf.arity != -1 && argCount != value -> pf.arity) {
+                    printf("Evaluation error: %s\n", value -> pf.arityError);
+                    texit(0);
                 }
-                Value *evaledArgs = evalEach(args, frame, needsReversal);
+                // the arguments are passed where they are on the stack, without building a list
+                value = (value -> pf.function)(argCount, stack + stackTop - argCount);
+                stackTop -= argCount + 1;
+                // a primitive returns here even from a tail call; the instruction after a tail call returns
+                push(value);
 
-                return apply(evaledOperator, evaledArgs);
+            } else {
+                // if the operator is not a function, throw an error.
+                printf("Evaluation error: non-function being called as function\n");
+                texit(0);
             }
-            break;
+            DISPATCH();
         }
-        default: {
-            break;
+        TARGET(OP_RETURN) {
+            if (returnTop == returnBase) {
+                return stack[--stackTop];
+            }
+            value = stack[--stackTop];
+            returnTop--;
+            code = returns[returnTop].code;
+            pc = returns[returnTop].pc;
+            frame = (Frame *)stack[stackTop - 1];
+            stack[stackTop - 1] = value;
+            DISPATCH();
+        }
+        TARGET(OP_NEW_FRAME) {
+            push((Value *)makeFrame(frame, OPERAND(instruction)));
+            DISPATCH();
+        }
+        TARGET(OP_BIND) {
+            value = stack[--stackTop];
+            bindLocal(code -> constants[OPERAND(instruction)], value, (Frame *)stack[stackTop - 1]);
+            DISPATCH();
+        }
+        TARGET(OP_ENTER) {
+            Frame *newFrame = (Frame *)stack[stackTop - 1];
+            stack[stackTop - 1] = (Value *)frame;
+            frame = newFrame;
+            DISPATCH();
+        }
+        TARGET(OP_ENTER_TAIL) {
+            frame = (Frame *)stack[--stackTop];
+            DISPATCH();
+        }
+        TARGET(OP_LEAVE) {
+            value = stack[--stackTop];
+            frame = (Frame *)stack[stackTop - 1];
+            stack[stackTop - 1] = value;
+            DISPATCH();
+        }
+        TARGET(OP_STORE_LOCAL0) {
+            frame -> slots[OPERAND(instruction)] = stack[--stackTop];
+            gcWriteBarrier(frame);
+            DISPATCH();
+        }
+        TARGET(OP_DEFINE) {
+            Value *variable = code -> constants[OPERAND(instruction)];
+            value = stack[--stackTop];
+            if (typeOf(variable) == LOCAL_TYPE) {
+                bindLocal(variable, value, frame);
+            } else {
+                addBinding(variable -> s, value);
+            }
+            push(VOID_VALUE);
+            DISPATCH();
+        }
+        TARGET(OP_SET) {
+            value = stack[--stackTop];
+            updateBinding(code -> constants[OPERAND(instruction)], value, frame);
+            push(VOID_VALUE);
+            DISPATCH();
+        }
+        TARGET(OP_ERROR) {
+            value = code -> constants[OPERAND(instruction)];
+            printf("Evaluation error: %.*s\n", value -> str.length, value -> str.chars);
+            texit(0);
         }
     }
-    return makeNull();    
+    // not reached
+    return NULL_VALUE;
 }
 
+#undef TARGET
+#undef DISPATCH
+
 /*
-printingHelper
-params: tree - a pointer to a Value struct, needsClose - a pointer to an integer
-returns: nothing
-Given a tree representing the result of evaluating a parse tree, print the contents of the tree.
+eval
+params: tree - a pointer to a Value representing a top-level form prepared by analyze(); frame - a pointer to a Frame
+returns: a pointer to a Value struct
+eval() compiles the form and runs the result on the virtual machine in the context of frame.
+A top-level form runs only once, so its code is released afterwards, which may collect garbage.
 */
-void printingHelper(Value *tree) {
-    Value *current;
-    Value *currentCar;
-    switch (tree->type) {
-        case INT_TYPE: {
-            printf("%i ", tree -> i);
-            break;
-        }
-        case DOUBLE_TYPE: {
-            printf("%lf ", tree -> d);
-            break;
-        }
-        case STR_TYPE: {
-            printf("%s ", tree -> s);
-            break;
-        }
-        case BOOL_TYPE: {
-            if (tree -> i == 1) {
-                printf("#t");
-            } else {
-                printf("#f");
-            }
-            break;
-        }
-        case SYMBOL_TYPE: {
-            printf("%s ", tree -> s);
-            break;
-        }
-        case CONS_TYPE: {
-            Value *current = tree;
-            printf("(");
-            while (current -> type != NULL_TYPE) {
-                currentCar = car(current);
-                if (cdr(current) -> type != CONS_TYPE && cdr(current) -> type != NULL_TYPE) {
-                    printingHelper(currentCar);
-                    printf(". ");
-                    printingHelper(cdr(current));
-                    break;
-                } else {
-                    printingHelper(currentCar);
-                }
-                current = cdr(current);
-            }
-            printf(") ");
-            break;
-        }
-        case NULL_TYPE: {
-            printf("()");
-            break;
-        }
-        case CLOSURE_TYPE: {
-            printf("#<procedure>");
-            break;
-        }
-        case PRIMITIVE_TYPE: {
-            printf("#<procedure>");
-            break;
-        }
-        default:
-            break;
-    }
+Value *eval(Value *tree, Frame *frame) {
+    Code *code = compile(tree);
+    Value *result = execute(code, frame);
+    gcPushRoot(&result);
+    releaseCode(code);
+    gcPopRoots(1);
+    return result;
 }
 
 /*
-interpret
-params: tree - a pointer to a Value struct
-returns: nothing
-Given the pointer to a Scheme program, iteratively call eval() on each parse tree and display their respective result.
+makeGlobalFrame
+params: None
+returns: a pointer to the global Frame
+Creates the global frame and binds the primitive functions in it, registering the interpreter's own roots with the
+garbage collector until releaseGlobalFrame(). The caller must register the returned frame as a root itself.
 */
-void interpret(Value *tree) {
-    Value *current = tree;
-    Frame *global = makeFrame(NULL);
+Frame *makeGlobalFrame() {
+    Frame *global = makeFrame(NULL, 0);
+    gcPushRoot(&globalValues);
+    gcSetRootStack(&stack, &stackTop);
     
     //add primitive functions to the global frame
-    bind("+", primitivePlus, global);
-    bind("-", primitiveMinus, global);
-    bind("=", primitiveEquals, global);
-    bind("<", primitiveLessThan, global);
-    bind(">", primitiveGreaterThan, global);
-    bind("null?", primitiveNull, global);
-    bind("car", primitiveCar, global);
-    bind("cdr", primitiveCdr, global);
-    bind("cons", primitiveCons, global);
+    bind("+", primitivePlus, -1, NULL);
+    bind("-", primitiveMinus, -1, NULL);
+    bind("=", primitiveEquals, 2, "incorrect number of arguments for =");
+    bind("<", primitiveLessThan, 2, "incorrect number of arguments for =");
+    bind(">", primitiveGreaterThan, 2, "incorrect number of arguments for =");
+    bind("null?", primitiveNull, 1, "incorrect number of args for 'null?'");
+    bind("car", primitiveCar, 1, "incorrect number of args for 'car'");
+    bind("cdr", primitiveCdr, 1, "incorrect number of args for 'cdr'");
+    bind("cons", primitiveCons, 2, "incorrect number of args for 'cons'");
+    return global;
+}
 
-    while (current->type != NULL_TYPE) {
-        Value *result = eval(car(current), global);
-        int needsClose = 0;
-        printingHelper(result);
-        if (result -> type != VOID_TYPE) {
-            printf("\n");
-        }
-        current = cdr(current);
-    }
+/*
+releaseGlobalFrame
+params: None
+returns: nothing
+Unregisters the root makeGlobalFrame() registered for the global table. The roots registered since must have been
+unregistered already.
+*/
+void releaseGlobalFrame() {
+    gcPopRoots(1);
+}
+
+/*
+interpret
+params: None
+returns: nothing
+Reads the Scheme program one top-level form at a time with readDatum(), calling eval() on each form and displaying its
+result before the next form is read. Output therefore appears as soon as each form is evaluated, and a form's parse
+tree can be collected once it has run.
+*/
+void interpret() {
+    Frame *global = makeGlobalFrame();
+    Value *form = NULL;
+    gcPushRoot(&form);
+    gcPushRoot(&global);
+    form = readDatum();
+    while (form != NULL) {
+        Value *result = eval(analyze(form), global);
+        writeValue(result);
+        if (typeOf(result) != VOID_TYPE) {
+            writeChar('\n');
+        }
+        flushOutput();
+
+        // the form is garbage now, along with whatever the reader allocated for it
+        form = NULL;
+        gcSafePoint();
+        form = readDatum();
+    }
+    gcPopRoots(2);
+    releaseGlobalFrame();
 }
 
 #endif
\ No newline at end of file
@@ -1,7 +1,18 @@
 #ifndef _INTERPRETER
 #define _INTERPRETER
 
-void interpret(Value *tree);
+// Reads, evaluates and prints each top-level form of the program in the input
+// opened by openInput(), one at a time.
+void interpret();
+
+// Creates the global frame, with the primitive functions bound in it, for
+// running forms with eval() directly. Call it once until the next tfree(), and
+// register the frame as a root with gcPushRoot(). When done with the frame,
+// pop that root and then call releaseGlobalFrame().
+Frame *makeGlobalFrame();
+void releaseGlobalFrame();
+
+// Evaluates one top-level form, as prepared by analyze(), in frame.
 Value *eval(Value *expr, Frame *frame);
 
 #endif
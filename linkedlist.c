@@ -5,50 +5,19 @@
 #include <string.h>
 #include <assert.h>
 #include "talloc.h"
+#include "linkedlist.h"
 
-#ifndef _LINKEDLIST
-#define _LINKEDLIST
+#ifndef _LINKEDLIST_C
+#define _LINKEDLIST_C
 
 // Looked up documentation for assert() at the following: https://www.geeksforgeeks.org/assertions-cc/
 // Functions appear in the order before they are called to prevent implicit definitions(?) from being created.
 
 // makeNull
 // params: None
-// returns: A new Value with type NULL_TYPE
+// returns: The Value with type NULL_TYPE, which is immediate
 Value *makeNull() {
-    Value *nullValue = talloc(sizeof(Value));
-    nullValue -> type = NULL_TYPE;
-    return nullValue;
-}
-
-// Cons
-// params: newCar - a pointer to a Value; newCdr - a pointer to a Value
-// returns: a new Value with type CONS_TYPE.
-// Sets the car and cdr of the value to point to the given parameters.
-Value *cons(Value *newCar, Value *newCdr) {
-    Value *consCell = talloc(sizeof(Value));
-    consCell -> type = CONS_TYPE;
-    consCell -> c.car = newCar;
-    consCell -> c.cdr = newCdr;
-    return consCell;
-}
-
-// car
-// params: list - a pointer to a Value
-// returns: a pointer to a Value
-// car returns the car of the given Value. Throws an error if list is not of type CONS_TYPE.
-Value *car(Value *list) {
-    assert(list -> type == CONS_TYPE);
-    return list -> c.car;
-}
-
-// cdr
-// params: list - a pointer to a Value
-// returns: a pointer to a Value
-// cdr returns the cdr of the given Value. Throws an error if list is not of type CONS_TYPE.
-Value *cdr(Value *list) {
-    assert(list -> type == CONS_TYPE);
-    return list -> c.cdr;
+    return NULL_VALUE;
 }
 
 // displayHelper
@@ -57,34 +26,34 @@ Value *cdr(Value *list) {
 // Helper method called by display() to print the items in list.
 void displayHelper(Value *list, int index) {
     Value *currentList = list;
-    switch (currentList -> type) {
+    switch (typeOf(currentList)) {
         case INT_TYPE:
-            printf("Integer at index %i: %i\n", index, currentList -> i);
+            printf("Integer at index %i: %i\n", index, intValue(currentList));
             break;
         case DOUBLE_TYPE:
             printf("Double at index %i: %lf\n", index, currentList -> d);
             break;
         case STR_TYPE:
-            printf("String at index %i: %s\n", index, currentList -> s);
+            printf("String at index %i: %.*s\n", index, currentList -> str.length, currentList -> str.chars);
             break;
         case PTR_TYPE:
             printf("Pointer at index %i\n", index);
             break;
         case OPEN_TYPE:
-            printf("Open parenthesis at index %i: %s\n", index, currentList -> s);
+            printf("Open parenthesis at index %i: (\n", index);
             break;
         case CLOSE_TYPE:
-            printf("Close parenthesis at index %i: %s\n", index, currentList -> s);
+            printf("Close parenthesis at index %i: )\n", index);
             break;
         case BOOL_TYPE:
-            printf("Boolean at index %i: %i\n", index, currentList -> i);
+            printf("Boolean at index %i: %i\n", index, boolValue(currentList));
             break;
         case SYMBOL_TYPE:
             printf("Symbol at index %i: %s\n", index, currentList -> s);
             break;
         case CONS_TYPE:
-            displayHelper(currentList -> c.car, index);
-            displayHelper(currentList -> c.cdr, index + 1);
+            displayHelper(car(currentList), index);
+            displayHelper(cdr(currentList), index + 1);
             break;
         case NULL_TYPE:
             printf("Null at index %i\n", index);
@@ -107,7 +76,7 @@ void display(Value *list) {
 // returns: a pointer to a Value
 // helper method called by reverse() to create a reversed version of list.
 Value *reverseHelper(Value *list, Value *reversed) {
-    switch (list -> type) {
+    switch (typeOf(list)) {
         case NULL_TYPE:
             return reversed;
         case INT_TYPE:
@@ -127,11 +96,11 @@ Value *reverseHelper(Value *list, Value *reversed) {
         case SYMBOL_TYPE:
             return list;
         case CONS_TYPE:
-            reversed = cons(reverseHelper(list -> c.car, reversed), reversed);
-            if (cdr(list) -> type == NULL_TYPE || cdr(list) -> type == CONS_TYPE) {
-                return reverseHelper(list -> c.cdr, reversed);
+            reversed = cons(reverseHelper(car(list), reversed), reversed);
+            if (typeOf(cdr(list)) == NULL_TYPE || typeOf(cdr(list)) == CONS_TYPE) {
+                return reverseHelper(cdr(list), reversed);
             } else {
-                return cons(reverseHelper(list -> c.cdr, reversed), reversed);
+                return cons(reverseHelper(cdr(list), reversed), reversed);
             }
         default:
             return list;
@@ -154,11 +123,7 @@ Value *reverse(Value *list) {
 // returns: true or false
 // Returns true if the type of the give Value is of NULL_TYPE, and false otherwise.
 bool isNull(Value *value) {
-    if (value -> type == NULL_TYPE) {
-        return true;
-    } else {
-        return false;
-    }
+    return value == NULL_VALUE;
 }
 
 // length
@@ -166,14 +131,14 @@ bool isNull(Value *value) {
 // returns: an integer
 // length iteratively finds the number of items in the linked list pointed to by value.
 int length(Value *value) {
-    if (value -> type == NULL_TYPE) {
+    if (typeOf(value) == NULL_TYPE) {
         return 0;
-    } else if (value -> type == CONS_TYPE) {
+    } else if (typeOf(value) == CONS_TYPE) {
         int count = 1;
         Value *current = value;
         Value *next = cdr(value);
 
-        while (next -> type != NULL_TYPE) {
+        while (typeOf(next) != NULL_TYPE) {
             current = next;
             next = cdr(next);
             count++;
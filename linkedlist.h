@@ -1,14 +1,24 @@
 #include <stdbool.h>
+#include <assert.h>
 #include "value.h"
+#include "talloc.h"
 
 #ifndef _LINKEDLIST
 #define _LINKEDLIST
 
-// Create a new NULL_TYPE value node.
+// Return the NULL_TYPE value, which is immediate (see value.h).
 Value *makeNull();
 
+// cons, car and cdr are called everywhere, so they are defined here to be
+// inlined. car and cdr assert that they are given a cons cell; compiling with
+// UNCHECKED_LISTS defined leaves the check out. Nothing user code does can
+// make them fail: the primitives and the compiler check the types themselves
+// and report evaluation errors.
+
 // Create a new CONS_TYPE value node.
-Value *cons(Value *newCar, Value *newCdr);
+static inline Value *cons(Value *newCar, Value *newCdr) {
+    return gcAllocCons(newCar, newCdr);
+}
 
 // Display the contents of the linked list to the screen in some kind of
 // readable format
@@ -22,11 +32,21 @@ Value *reverse(Value *list);
 
 // Utility to make it less typing to get car value. Use assertions to make sure
 // that this is a legitimate operation.
-Value *car(Value *list);
+static inline Value *car(Value *list) {
+#ifndef UNCHECKED_LISTS
+    assert(typeOf(list) == CONS_TYPE);
+#endif
+    return consCell(list) -> car;
+}
 
 // Utility to make it less typing to get cdr value. Use assertions to make sure
 // that this is a legitimate operation.
-Value *cdr(Value *list);
+static inline Value *cdr(Value *list) {
+#ifndef UNCHECKED_LISTS
+    assert(typeOf(list) == CONS_TYPE);
+#endif
+    return consCell(list) -> cdr;
+}
 
 // Utility to check if pointing to a NULL_TYPE value. Use assertions to make sure
 // that this is a legitimate operation.
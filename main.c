@@ -6,12 +6,18 @@
 #include "talloc.h"
 #include "interpreter.h"
 
-int main() {
+// Runs the program in the file named by the only argument, or, if there is no
+// argument, the program read from stdin.
+int main(int argc, char *argv[]) {
 
-    Value *list = tokenize();
-    Value *tree = parse(list);
-    interpret(tree);
+    if (argc > 2) {
+        printf("Usage: %s [file]\n", argv[0]);
+        return 1;
+    }
+    openInput(argc == 2 ? argv[1] : NULL);
+    interpret();
 
     tfree();
+    releaseInput();
     return 0;
 }
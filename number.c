@@ -0,0 +1,460 @@
+#include "talloc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <float.h>
+#include <math.h>
+
+#ifndef _NUMBER
+#define _NUMBER
+
+// Number literals are read straight from the input, without copying them out
+// first. Most doubles are read with Clinger's fast path: when the digits fit
+// in the 53 bits of a double's significand and the power of ten they are
+// scaled by is exact as a double too, a single multiplication or division
+// rounds correctly. Anything else goes to strtod.
+//
+// Doubles are written with Florian Loitsch's Grisu2 algorithm ("Printing
+// Floating-Point Numbers Quickly and Accurately with Integers", 2010). It
+// scales the double and the bounds of the interval of reals that round to it
+// by a cached power of ten, using 64-bit integer arithmetic only, and then
+// generates digits until they pin down a number inside the interval.
+
+// powers of ten that are exact as doubles
+double exactPowersOfTen[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// parseInteger
+// params: chars - a pointer to an integer literal; length - the number of characters in it
+// returns: the int the literal denotes
+// parseInteger saturates at the range of a long before casting to int, which is what converting with strtol did
+int parseInteger(char *chars, int length) {
+    int index = 0;
+    bool negative = false;
+    if (chars[0] == '+' || chars[0] == '-') {
+        negative = chars[0] == '-';
+        index++;
+    }
+
+    unsigned long magnitude = 0;
+    bool overflow = false;
+    while (index < length) {
+        unsigned long digit = chars[index] - '0';
+        if (magnitude > (ULONG_MAX - digit) / 10) {
+            overflow = true;
+        } else {
+            magnitude = magnitude * 10 + digit;
+        }
+        index++;
+    }
+
+    long number;
+    if (negative) {
+        number = overflow || magnitude > (unsigned long)LONG_MAX + 1 ? LONG_MIN : (long)(0 - magnitude);
+    } else {
+        number = overflow || magnitude > LONG_MAX ? LONG_MAX : (long)magnitude;
+    }
+    return (int)number;
+}
+
+// parseDouble
+// params: chars - a pointer to a decimal literal; length - the number of characters in it
+// returns: the double the literal denotes
+double parseDouble(char *chars, int length) {
+    int index = 0;
+    bool negative = false;
+    if (chars[0] == '+' || chars[0] == '-') {
+        negative = chars[0] == '-';
+        index++;
+    }
+
+    // the infinities and NaN, which have no digits
+    if (chars[index] == 'i') {
+        return negative ? -INFINITY : INFINITY;
+    }
+    if (chars[index] == 'n') {
+        return negative ? -NAN : NAN;
+    }
+
+    // gather the significant digits, and count those after the point
+    uint64_t significand = 0;
+    int digits = 0;
+    int fractionDigits = 0;
+    bool afterPoint = false;
+    while (index < length && chars[index] != 'e' && chars[index] != 'E') {
+        if (chars[index] == '.') {
+            afterPoint = true;
+        } else if (digits < 19) {
+            significand = significand * 10 + (chars[index] - '0');
+            if (significand != 0) {
+                digits++;
+            }
+            if (afterPoint) {
+                fractionDigits++;
+            }
+        } else {
+            digits++;
+        }
+        index++;
+    }
+
+    // the exponent, if any, which stops growing long before it could overflow, since strtod reads the large ones
+    int exponent = 0;
+    if (index < length) {
+        index++;
+        bool negativeExponent = chars[index] == '-';
+        if (chars[index] == '+' || chars[index] == '-') {
+            index++;
+        }
+        while (index < length) {
+            if (exponent < 100000) {
+                exponent = exponent * 10 + (chars[index] - '0');
+            }
+            index++;
+        }
+        if (negativeExponent) {
+            exponent = -exponent;
+        }
+    }
+
+    // the fast path, when both the significand and the power of ten are exact
+    int scale = exponent - fractionDigits;
+    if (digits <= 19 && significand <= (UINT64_C(1) << 53) && scale >= -22 && scale <= 22) {
+        double number = scale < 0 ? (double)significand / exactPowersOfTen[-scale]
+                                  : (double)significand * exactPowersOfTen[scale];
+        return negative ? -number : number;
+    }
+
+    // strtod needs a null-terminated copy
+    char text[64];
+    char *copy = length < 64 ? text : talloc((length + 1) * sizeof(char));
+    memcpy(copy, chars, length);
+    copy[length] = '\0';
+    return strtod(copy, NULL);
+}
+
+// A DiyFp is a floating-point number with a 64-bit significand f and a binary exponent e, standing for f * 2^e, which
+// Grisu computes with instead of doubles.
+typedef struct DiyFp {
+    uint64_t f;
+    int e;
+} DiyFp;
+
+// the normalized powers of ten 10^k, for k from -300 to 324 in steps of 8, as f * 2^e with f rounded to nearest
+typedef struct CachedPower {
+    uint64_t f;
+    int e;
+    int k;
+} CachedPower;
+
+CachedPower cachedPowers[] = {
+    {0xAB70FE17C79AC6CAULL, -1060, -300},
+    {0xFF77B1FCBEBCDC4FULL, -1034, -292},
+    {0xBE5691EF416BD60CULL, -1007, -284},
+    {0x8DD01FAD907FFC3CULL, -980, -276},
+    {0xD3515C2831559A83ULL, -954, -268},
+    {0x9D71AC8FADA6C9B5ULL, -927, -260},
+    {0xEA9C227723EE8BCBULL, -901, -252},
+    {0xAECC49914078536DULL, -874, -244},
+    {0x823C12795DB6CE57ULL, -847, -236},
+    {0xC21094364DFB5637ULL, -821, -228},
+    {0x9096EA6F3848984FULL, -794, -220},
+    {0xD77485CB25823AC7ULL, -768, -212},
+    {0xA086CFCD97BF97F4ULL, -741, -204},
+    {0xEF340A98172AACE5ULL, -715, -196},
+    {0xB23867FB2A35B28EULL, -688, -188},
+    {0x84C8D4DFD2C63F3BULL, -661, -180},
+    {0xC5DD44271AD3CDBAULL, -635, -172},
+    {0x936B9FCEBB25C996ULL, -608, -164},
+    {0xDBAC6C247D62A584ULL, -582, -156},
+    {0xA3AB66580D5FDAF6ULL, -555, -148},
+    {0xF3E2F893DEC3F126ULL, -529, -140},
+    {0xB5B5ADA8AAFF80B8ULL, -502, -132},
+    {0x87625F056C7C4A8BULL, -475, -124},
+    {0xC9BCFF6034C13053ULL, -449, -116},
+    {0x964E858C91BA2655ULL, -422, -108},
+    {0xDFF9772470297EBDULL, -396, -100},
+    {0xA6DFBD9FB8E5B88FULL, -369, -92},
+    {0xF8A95FCF88747D94ULL, -343, -84},
+    {0xB94470938FA89BCFULL, -316, -76},
+    {0x8A08F0F8BF0F156BULL, -289, -68},
+    {0xCDB02555653131B6ULL, -263, -60},
+    {0x993FE2C6D07B7FACULL, -236, -52},
+    {0xE45C10C42A2B3B06ULL, -210, -44},
+    {0xAA242499697392D3ULL, -183, -36},
+    {0xFD87B5F28300CA0EULL, -157, -28},
+    {0xBCE5086492111AEBULL, -130, -20},
+    {0x8CBCCC096F5088CCULL, -103, -12},
+    {0xD1B71758E219652CULL, -77, -4},
+    {0x9C40000000000000ULL, -50, 4},
+    {0xE8D4A51000000000ULL, -24, 12},
+    {0xAD78EBC5AC620000ULL, 3, 20},
+    {0x813F3978F8940984ULL, 30, 28},
+    {0xC097CE7BC90715B3ULL, 56, 36},
+    {0x8F7E32CE7BEA5C70ULL, 83, 44},
+    {0xD5D238A4ABE98068ULL, 109, 52},
+    {0x9F4F2726179A2245ULL, 136, 60},
+    {0xED63A231D4C4FB27ULL, 162, 68},
+    {0xB0DE65388CC8ADA8ULL, 189, 76},
+    {0x83C7088E1AAB65DBULL, 216, 84},
+    {0xC45D1DF942711D9AULL, 242, 92},
+    {0x924D692CA61BE758ULL, 269, 100},
+    {0xDA01EE641A708DEAULL, 295, 108},
+    {0xA26DA3999AEF774AULL, 322, 116},
+    {0xF209787BB47D6B85ULL, 348, 124},
+    {0xB454E4A179DD1877ULL, 375, 132},
+    {0x865B86925B9BC5C2ULL, 402, 140},
+    {0xC83553C5C8965D3DULL, 428, 148},
+    {0x952AB45CFA97A0B3ULL, 455, 156},
+    {0xDE469FBD99A05FE3ULL, 481, 164},
+    {0xA59BC234DB398C25ULL, 508, 172},
+    {0xF6C69A72A3989F5CULL, 534, 180},
+    {0xB7DCBF5354E9BECEULL, 561, 188},
+    {0x88FCF317F22241E2ULL, 588, 196},
+    {0xCC20CE9BD35C78A5ULL, 614, 204},
+    {0x98165AF37B2153DFULL, 641, 212},
+    {0xE2A0B5DC971F303AULL, 667, 220},
+    {0xA8D9D1535CE3B396ULL, 694, 228},
+    {0xFB9B7CD9A4A7443CULL, 720, 236},
+    {0xBB764C4CA7A44410ULL, 747, 244},
+    {0x8BAB8EEFB6409C1AULL, 774, 252},
+    {0xD01FEF10A657842CULL, 800, 260},
+    {0x9B10A4E5E9913129ULL, 827, 268},
+    {0xE7109BFBA19C0C9DULL, 853, 276},
+    {0xAC2820D9623BF429ULL, 880, 284},
+    {0x80444B5E7AA7CF85ULL, 907, 292},
+    {0xBF21E44003ACDD2DULL, 933, 300},
+    {0x8E679C2F5E44FF8FULL, 960, 308},
+    {0xD433179D9C8CB841ULL, 986, 316},
+    {0x9E19DB92B4E31BA9ULL, 1013, 324},
+};
+
+// the range the binary exponent of a scaled number is brought into, so that its integral part fits in 32 bits
+#define GRISU_ALPHA (-60)
+#define GRISU_GAMMA (-32)
+
+// diyFpSub
+// params: x, y - DiyFps with the same exponent, x no smaller than y
+// returns: x - y
+DiyFp diyFpSub(DiyFp x, DiyFp y) {
+    DiyFp difference = {x.f - y.f, x.e};
+    return difference;
+}
+
+// diyFpMultiply
+// params: x, y - DiyFps
+// returns: x * y, rounded to the upper 64 bits of the full 128-bit product
+DiyFp diyFpMultiply(DiyFp x, DiyFp y) {
+    uint64_t xLow = x.f & 0xFFFFFFFFu;
+    uint64_t xHigh = x.f >> 32;
+    uint64_t yLow = y.f & 0xFFFFFFFFu;
+    uint64_t yHigh = y.f >> 32;
+
+    uint64_t lowLow = xLow * yLow;
+    uint64_t lowHigh = xLow * yHigh;
+    uint64_t highLow = xHigh * yLow;
+    uint64_t highHigh = xHigh * yHigh;
+
+    // the middle 32 bits of the product, plus half of the lowest bit kept, to round
+    uint64_t middle = (lowLow >> 32) + (lowHigh & 0xFFFFFFFFu) + (highLow & 0xFFFFFFFFu) + (UINT64_C(1) << 31);
+    DiyFp product = {highHigh + (lowHigh >> 32) + (highLow >> 32) + (middle >> 32), x.e + y.e + 64};
+    return product;
+}
+
+// diyFpNormalize
+// params: x - a DiyFp whose significand is not zero
+// returns: x, shifted so that the top bit of its significand is set
+DiyFp diyFpNormalize(DiyFp x) {
+    while ((x.f >> 63) == 0) {
+        x.f = x.f << 1;
+        x.e--;
+    }
+    return x;
+}
+
+// grisuRound
+// params: digits - the digits generated so far; length - how many there are; distance - the distance from the upper
+// bound to the scaled number; delta - the width of the interval; rest - the distance from the upper bound to the
+// digits; tenK - the value of one unit in the last digit
+// returns: Nothing
+// grisuRound lowers the last digit for as long as that keeps it inside the interval and brings it closer to the number
+void grisuRound(char *digits, int length, uint64_t distance, uint64_t delta, uint64_t rest, uint64_t tenK) {
+    while (rest < distance && delta - rest >= tenK
+           && (rest + tenK < distance || distance - rest > rest + tenK - distance)) {
+        digits[length - 1]--;
+        rest = rest + tenK;
+    }
+}
+
+// grisuDigits
+// params: digits - where to put the digits; exponent - a pointer to the decimal exponent of the scaled number, which
+// is updated to be that of the last digit; low, number, high - the scaled number and the bounds of its interval,
+// sharing an exponent between GRISU_ALPHA and GRISU_GAMMA
+// returns: the number of digits generated
+// grisuDigits produces the digits of high from the left, stopping as soon as they are within the interval
+int grisuDigits(char *digits, int *exponent, DiyFp low, DiyFp number, DiyFp high) {
+    uint64_t delta = diyFpSub(high, low).f;
+    uint64_t distance = diyFpSub(high, number).f;
+    int shift = -high.e;
+    uint64_t one = UINT64_C(1) << shift;
+    uint32_t integral = (uint32_t)(high.f >> shift);
+    uint64_t fraction = high.f & (one - 1);
+    int length = 0;
+
+    // the number of digits in the integral part, and the power of ten of the first
+    uint32_t power = 1;
+    int remaining = 1;
+    while (remaining < 10 && power * 10 <= integral) {
+        power = power * 10;
+        remaining++;
+    }
+
+    // digits of the integral part
+    while (remaining > 0) {
+        digits[length] = '0' + integral / power;
+        length++;
+        integral = integral % power;
+        remaining--;
+        uint64_t rest = ((uint64_t)integral << shift) + fraction;
+        if (rest <= delta) {
+            *exponent = *exponent + remaining;
+            grisuRound(digits, length, distance, delta, rest, (uint64_t)power << shift);
+            return length;
+        }
+        power = power / 10;
+    }
+
+    // digits of the fractional part
+    int fractionDigits = 0;
+    do {
+        fraction = fraction * 10;
+        digits[length] = '0' + (fraction >> shift);
+        length++;
+        fraction = fraction & (one - 1);
+        fractionDigits++;
+        delta = delta * 10;
+        distance = distance * 10;
+    } while (fraction > delta);
+    *exponent = *exponent - fractionDigits;
+    grisuRound(digits, length, distance, delta, fraction, one);
+    return length;
+}
+
+// grisu2
+// params: value - a finite, positive double; digits - where to put its digits, with room for 17; exponent - a pointer
+// to where to put the decimal exponent of the last digit
+// returns: the number of digits generated
+int grisu2(double value, char *digits, int *exponent) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(double));
+    uint64_t fraction = bits & ((UINT64_C(1) << 52) - 1);
+    int biasedExponent = (int)(bits >> 52);
+
+    // value, and the bounds halfway to its neighbours, which are closer together below a power of two
+    DiyFp number;
+    if (biasedExponent == 0) {
+        number.f = fraction;
+        number.e = 1 - 1075;
+    } else {
+        number.f = fraction + (UINT64_C(1) << 52);
+        number.e = biasedExponent - 1075;
+    }
+    DiyFp high = {2 * number.f + 1, number.e - 1};
+    DiyFp low;
+    if (fraction == 0 && biasedExponent > 1) {
+        low.f = 4 * number.f - 1;
+        low.e = number.e - 2;
+    } else {
+        low.f = 2 * number.f - 1;
+        low.e = number.e - 1;
+    }
+    high = diyFpNormalize(high);
+    low.f = low.f << (low.e - high.e);
+    low.e = high.e;
+    number = diyFpNormalize(number);
+
+    // scale by the cached power of ten that brings the exponent into range
+    int target = GRISU_ALPHA - high.e - 1;
+    int k = (target * 78913) / (1 << 18) + (target > 0);
+    CachedPower cached = cachedPowers[(300 + k + 7) / 8];
+    DiyFp power = {cached.f, cached.e};
+    DiyFp scaled = diyFpMultiply(number, power);
+    DiyFp scaledLow = diyFpMultiply(low, power);
+    DiyFp scaledHigh = diyFpMultiply(high, power);
+
+    // the products may be off by one unit, so the interval is narrowed by one to be safe
+    scaledLow.f++;
+    scaledHigh.f--;
+    *exponent = -cached.k;
+    return grisuDigits(digits, exponent, scaledLow, scaled, scaledHigh);
+}
+
+// formatDouble
+// params: number - a double; buffer - where to write the text, with room for DOUBLE_TEXT_LENGTH characters
+// returns: the number of characters written
+// formatDouble writes numbers from 10^-7 up to 10^21 in positional notation, and the rest in scientific notation
+int formatDouble(double number, char *buffer) {
+    int length = 0;
+    if (number != number) {
+        memcpy(buffer, "+nan.0", 6);
+        return 6;
+    }
+    if (signbit(number)) {
+        buffer[length] = '-';
+        length++;
+        number = -number;
+    }
+    if (number == 0) {
+        memcpy(buffer + length, "0.0", 3);
+        return length + 3;
+    }
+    if (number > DBL_MAX) {
+        if (length == 0) {
+            buffer[length] = '+';
+            length++;
+        }
+        memcpy(buffer + length, "inf.0", 5);
+        return length + 5;
+    }
+
+    char digits[18];
+    int exponent;
+    int count = grisu2(number, digits, &exponent);
+
+    // point is where the decimal point goes, counting from the first digit
+    int point = count + exponent;
+    if (point > 21 || point < -6) {
+        buffer[length] = digits[0];
+        length++;
+        if (count > 1) {
+            buffer[length] = '.';
+            memcpy(buffer + length + 1, digits + 1, count - 1);
+            length = length + count;
+        }
+        length = length + sprintf(buffer + length, "e%d", point - 1);
+    } else if (point >= count) {
+        memcpy(buffer + length, digits, count);
+        memset(buffer + length + count, '0', point - count);
+        length = length + point;
+        memcpy(buffer + length, ".0", 2);
+        length = length + 2;
+    } else if (point > 0) {
+        memcpy(buffer + length, digits, point);
+        buffer[length + point] = '.';
+        memcpy(buffer + length + point + 1, digits + point, count - point);
+        length = length + count + 1;
+    } else {
+        memcpy(buffer + length, "0.", 2);
+        memset(buffer + length + 2, '0', -point);
+        memcpy(buffer + length + 2 - point, digits, count);
+        length = length + 2 - point + count;
+    }
+    return length;
+}
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef _NUMBER
+#define _NUMBER
+
+// Conversions between numbers and their text, used by the tokenizer to read
+// number literals and by output.c to write doubles.
+
+// The most characters formatDouble() writes.
+#define DOUBLE_TEXT_LENGTH 32
+
+// Returns the int an integer literal denotes: the first length characters of
+// chars, which are an optional sign and then digits. A literal out of range
+// comes out the same as strtol's result cast to int.
+int parseInteger(char *chars, int length);
+
+// Returns the double a decimal literal denotes, correctly rounded: the first
+// length characters of chars, which are an optional sign, then digits with a
+// decimal point, an exponent (e or E, an optional sign and digits) or both,
+// or else +inf.0, -inf.0, +nan.0 or -nan.0.
+double parseDouble(char *chars, int length);
+
+// Writes the text of number to buffer, which must have room for
+// DOUBLE_TEXT_LENGTH characters, and returns how many characters it wrote.
+// The text is not null-terminated. Numbers from 10^-7 up to 10^21 are written
+// without an exponent, and whole numbers among them end in .0; the rest are
+// written with one, as in 1e21 or 5e-324. The infinities are written +inf.0
+// and -inf.0, and NaN +nan.0. The text has as few digits as possible in all
+// but a tiny fraction of cases, and the tokenizer reads it back as a double:
+// exactly number, or a NaN if number is one, though not necessarily the same
+// NaN. strtod reads back all but the infinities and NaN.
+int formatDouble(double number, char *buffer);
+
+#endif
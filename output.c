@@ -0,0 +1,176 @@
+#include "value.h"
+#include "linkedlist.h"
+#include "talloc.h"
+#include "number.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifndef _OUTPUT
+#define _OUTPUT
+
+// size of the output buffer
+#define OUTPUT_BUFFER_SIZE (64 * 1024)
+
+// define global output buffer, along with the number of characters in it
+char outputBuffer[OUTPUT_BUFFER_SIZE];
+int outputLength = 0;
+
+// flushOutput
+// params: None
+// returns: Nothing
+// flushOutput hands everything in the buffer to stdout in one piece, and empties it
+void flushOutput() {
+    if (outputLength > 0) {
+        fwrite(outputBuffer, 1, outputLength, stdout);
+        outputLength = 0;
+    }
+}
+
+// writeChar
+// params: c - a character
+// returns: Nothing
+void writeChar(char c) {
+    if (outputLength == OUTPUT_BUFFER_SIZE) {
+        flushOutput();
+    }
+    outputBuffer[outputLength] = c;
+    outputLength++;
+}
+
+// writeText
+// params: chars - a pointer to characters; length - the number of characters to write
+// returns: Nothing
+// text too long to fit in the buffer even once it is empty is written straight to stdout
+void writeText(char *chars, int length) {
+    if (OUTPUT_BUFFER_SIZE - outputLength < length) {
+        flushOutput();
+        if (length > OUTPUT_BUFFER_SIZE) {
+            fwrite(chars, 1, length, stdout);
+            return;
+        }
+    }
+    memcpy(outputBuffer + outputLength, chars, length);
+    outputLength = outputLength + length;
+}
+
+// writeString
+// params: string - a null-terminated string
+// returns: Nothing
+void writeString(char *string) {
+    writeText(string, strlen(string));
+}
+
+// writeInt
+// params: number - an integer
+// returns: Nothing
+// writeInt produces the digits from the lowest up, at the end of a scratch array, and then writes them
+void writeInt(int number) {
+    char digits[12];  // enough for a sign and the ten digits of the largest int
+    int start = 12;
+    // the magnitude is taken as unsigned, so that the most negative int has one too
+    unsigned int magnitude = number < 0 ? 0u - (unsigned int)number : (unsigned int)number;
+    do {
+        start--;
+        digits[start] = '0' + magnitude % 10;
+        magnitude = magnitude / 10;
+    } while (magnitude != 0);
+    if (number < 0) {
+        start--;
+        digits[start] = '-';
+    }
+    writeText(digits + start, 12 - start);
+}
+
+// writeDouble
+// params: number - a double
+// returns: Nothing
+// writeDouble formats number straight into the buffer
+void writeDouble(double number) {
+    if (OUTPUT_BUFFER_SIZE - outputLength < DOUBLE_TEXT_LENGTH) {
+        flushOutput();
+    }
+    outputLength = outputLength + formatDouble(number, outputBuffer + outputLength);
+}
+
+// writeAtom
+// params: value - a pointer to a Value that is not a CONS_TYPE
+// returns: Nothing
+// writeAtom writes value the way writeValue() does
+void writeAtom(Value *value) {
+    switch (typeOf(value)) {
+        case INT_TYPE:
+            writeInt(intValue(value));
+            writeChar(' ');
+            break;
+        case DOUBLE_TYPE:
+            writeDouble(value -> d);
+            writeChar(' ');
+            break;
+        case STR_TYPE:
+            writeText(value -> str.chars, value -> str.length);
+            writeChar(' ');
+            break;
+        case BOOL_TYPE:
+            writeText(boolValue(value) ? "#t" : "#f", 2);
+            break;
+        case SYMBOL_TYPE:
+            writeString(value -> s);
+            writeChar(' ');
+            break;
+        case NULL_TYPE:
+            writeText("()", 2);
+            break;
+        case CLOSURE_TYPE:
+        case PRIMITIVE_TYPE:
+            writeString("#<procedure>");
+            break;
+        default:
+            break;
+    }
+}
+
+// writeValue
+// params: value - a pointer to a Value
+// returns: Nothing
+// writeValue walks lists with a loop, keeping the rest of each list it is inside of on a stack made of cons cells. It
+// allocates, but never reaches a safe point, so the stack needs no roots.
+void writeValue(Value *value) {
+    if (typeOf(value) != CONS_TYPE) {
+        writeAtom(value);
+        return;
+    }
+
+    Value *rest = value;  // the items of the innermost list being written that are still to come
+    Value *enclosing = makeNull();  // for each list outside that one, the rest of its items, innermost first
+    writeChar('(');
+    while (true) {
+        if (typeOf(rest) == CONS_TYPE) {
+            Value *item = car(rest);
+            rest = cdr(rest);
+
+            // start on a sublist, setting aside the rest of the list it is in
+            if (typeOf(item) == CONS_TYPE) {
+                writeChar('(');
+                enclosing = cons(rest, enclosing);
+                rest = item;
+            } else {
+                writeAtom(item);
+            }
+
+        // the list is finished, with a dot before its last item if it is not a proper list
+        } else {
+            if (!isNull(rest)) {
+                writeText(". ", 2);
+                writeAtom(rest);
+            }
+            writeText(") ", 2);
+            if (isNull(enclosing)) {
+                return;
+            }
+            rest = car(enclosing);
+            enclosing = cdr(enclosing);
+        }
+    }
+}
+
+#endif
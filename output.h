@@ -0,0 +1,36 @@
+#include "value.h"
+
+#ifndef _OUTPUT
+#define _OUTPUT
+
+// Everything the interpreter prints, other than error messages, goes through
+// these functions. They collect the text in a large buffer, which is only
+// written to stdout when it fills up or flushOutput() is called, rather than
+// calling printf for every piece. Call flushOutput() before anything else
+// might print, so that the output stays in order.
+
+// Write a single character.
+void writeChar(char c);
+
+// Write the first length characters of chars, which need not be
+// null-terminated.
+void writeText(char *chars, int length);
+
+// Write a null-terminated string.
+void writeString(char *string);
+
+// Write an integer in decimal.
+void writeInt(int number);
+
+// Write a double as formatDouble() in number.h does.
+void writeDouble(double number);
+
+// Write a Value the way results are displayed, with a space after each atom
+// except booleans, the empty list and procedures. Lists are written without
+// recursion, however long or deeply nested they are.
+void writeValue(Value *value);
+
+// Write everything still in the buffer to stdout.
+void flushOutput();
+
+#endif
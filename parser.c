@@ -2,120 +2,149 @@
 #include "linkedlist.h"
 #include "talloc.h"
 #include "tokenizer.h"
+#include "output.h"
 #include <string.h>
 #include <stdio.h>
 
 #ifndef _PARSER
 #define _PARSER
 
-// parse
-// params: tokens - a pointer to a Value representing a list of tokens
-// returns: a pointer to a Value representing a list of parse trees
-// parse() creates a series of parse trees based on the provided tokens. It throws a syntax error if it encounters mismatched parentheses.
-Value *parse(Value *tokens) {
+// reverseItems
+// params: items - a pointer to a Value representing a list built by readDatum()
+// returns: a pointer to a Value representing the same list, reversed in place
+// readDatum() has only just allocated the list's cells, and nothing can have been collected since, so they are
+// updated without a write barrier
+Value *reverseItems(Value *items) {
+    Value *reversed = makeNull();
+    while (!isNull(items)) {
+        Value *next = cdr(items);
+        consCell(items) -> cdr = reversed;
+        reversed = items;
+        items = next;
+    }
+    return reversed;
+}
 
-    Value *parseTrees = makeNull();
-    Value *flippedParseTrees;
-    Value *currentToken = tokens;
-    Value *parseTree;
+// readDatum
+// params: None
+// returns: a pointer to a Value representing the next parse tree in the input, or NULL at the end of the input
+// readDatum() builds the parse tree straight from the tokens as nextToken() scans them, and stops as soon as the tree
+// is complete. It throws a syntax error if it encounters mismatched parentheses.
+Value *readDatum() {
+    Value *openLists = makeNull();  // for each list still open, the items read before it, most recent first
+    Value *items = makeNull();  // the items read so far in the innermost open list, most recent first
+    Value *token = nextToken();
 
-    while (currentToken -> type != NULL_TYPE) {
-        
-        // if close paren seen, make a new parse tree and add it to the stack
-        if (car(currentToken) -> type == CLOSE_TYPE) {
-            parseTree = makeNull();
+    while (token != NULL) {
+        Value *datum = token;
 
-            while (car(parseTrees) -> type != OPEN_TYPE) {
-                // error check for extra close parens
-                if (cdr(parseTrees) -> type == NULL_TYPE) {
-                    printf("Syntax error: too many close parentheses\n");
-                    texit(0);
-                } else {
-                    parseTree = cons(car(parseTrees), parseTree);
-                    parseTrees = cdr(parseTrees);
-                }
+        // if open paren seen, start a new list, setting aside the one it is in
+        if (token == OPEN_VALUE) {
+            openLists = cons(items, openLists);
+            items = makeNull();
+            token = nextToken();
+            continue;
+
+        // if close paren seen, the innermost open list is finished, and becomes an item of the one it is in
+        } else if (token == CLOSE_VALUE) {
+            // error check for extra close parens
+            if (isNull(openLists)) {
+                printf("Syntax error: too many close parentheses\n");
+                texit(0);
             }
+            datum = reverseItems(items);
 
             // Ensuring parse tree is properly made into a series of cons cells if no tokens present other than parens
-            if (parseTree -> type == NULL_TYPE) {
-                parseTree = cons(parseTree, makeNull());
+            if (isNull(datum)) {
+                datum = cons(datum, makeNull());
             }
-
-            parseTrees = cons(parseTree, cdr(parseTrees));
-
-        } else {
-            parseTrees = cons(car(currentToken), parseTrees);
+            items = car(openLists);
+            openLists = cdr(openLists);
         }
 
-        currentToken = cdr(currentToken);
+        // a datum outside of any list is a whole parse tree
+        if (isNull(openLists)) {
+            return datum;
+        }
+        items = cons(datum, items);
+        token = nextToken();
     }
 
-    // reverse order of the list of parse trees to maintain proper order of parsed tokens
-    flippedParseTrees = makeNull();
-    Value *currentParseTree = parseTrees;
-    while (currentParseTree -> type != NULL_TYPE) {
-        // error check for extra open parens
-        if (car(currentParseTree) -> type == OPEN_TYPE) {
-            printf("Syntax error: not enough close parentheses\n");
-            texit(0);
-        } else {
-            flippedParseTrees = cons(car(currentParseTree), flippedParseTrees);
-            currentParseTree = cdr(currentParseTree);
-        }
+    // error check for extra open parens
+    if (!isNull(openLists)) {
+        printf("Syntax error: not enough close parentheses\n");
+        texit(0);
     }
+    return NULL;
+}
 
-    return flippedParseTrees;
+// parse
+// params: None
+// returns: a pointer to a Value representing a list of parse trees
+// parse() reads parse trees with readDatum() until the end of the input
+Value *parse() {
+    Value *parseTrees = makeNull();
+    Value *parseTree = readDatum();
+    while (parseTree != NULL) {
+        parseTrees = cons(parseTree, parseTrees);
+        parseTree = readDatum();
+    }
+    return reverseItems(parseTrees);
 }
 
 // printTree
 // params: tree - a pointer to a Value representing a list of parse trees
 // returns: Nothing
-// printTree uses a mix of iteration and recursion to print the contents of all nodes in each parse tree in the given list.
+// printTree prints the contents of all nodes in each parse tree in the given list, walking subtrees with a loop and a
+// stack of the rest of each list it is inside of, rather than recursion.
 // Prints all output in one line. Leaves an extra space after the last item in a list.
 void printTree(Value *tree) {
-    Value *current = tree;
+    Value *rest = tree;  // the items of the innermost list being printed that are still to come
+    Value *enclosing = makeNull();  // for each list outside that one, the rest of its items, innermost first
     Value *currentCar;
-    // iteration to print contents of multiple parse trees
-    while (current -> type != NULL_TYPE) {
-        currentCar = car(current);
-        switch (currentCar -> type) {
+
+    while (!isNull(rest) || !isNull(enclosing)) {
+
+        // the innermost subtree is finished; carry on with the list it is in
+        if (isNull(rest)) {
+            writeText(") ", 2);
+            rest = car(enclosing);
+            enclosing = cdr(enclosing);
+            continue;
+        }
+
+        currentCar = car(rest);
+        rest = cdr(rest);
+        switch (typeOf(currentCar)) {
             case INT_TYPE:
-                printf("%i ", currentCar -> i);
+                writeInt(intValue(currentCar));
+                writeChar(' ');
                 break;
             case DOUBLE_TYPE:
-                printf("%lf ", currentCar -> d);
+                writeDouble(currentCar -> d);
+                writeChar(' ');
                 break;
             case STR_TYPE:
-                printf("%s ", currentCar -> s);
+                writeText(currentCar -> str.chars, currentCar -> str.length);
+                writeChar(' ');
                 break;
             case BOOL_TYPE:
-                if (currentCar -> i == 1) {
-                    printf("#t ");
-                } else {
-                    printf("#f ");
-                }
+                writeText(boolValue(currentCar) ? "#t " : "#f ", 3);
                 break;
             case SYMBOL_TYPE:
-                printf("%s ", currentCar -> s);
+                writeString(currentCar -> s);
+                writeChar(' ');
                 break;
             case CONS_TYPE:
-                printf("(");
-                // recursion to print contents of subtrees of a parse tree
-                printTree(currentCar);
-                printf(") ");
+                writeChar('(');
+                enclosing = cons(rest, enclosing);
+                rest = currentCar;
                 break;
             default:
                 break;
         }
-        current = cdr(current);
     }
+    flushOutput();
 }
 
-// int main() {
-//     Value *tokens = tokenize();
-//     Value *parseTrees = parse(tokens);
-//     printTree(parseTrees);
-//     return 1;
-// }
-
 #endif
\ No newline at end of file
@@ -3,9 +3,14 @@
 #ifndef _PARSER
 #define _PARSER
 
-// Takes a list of tokens from a Scheme program, and returns a pointer to a
-// parse tree representing that program.
-Value *parse(Value *tokens);
+// Reads the next top-level datum of the program from the input opened by
+// openInput(), scanning only as far as its end, and returns a pointer to a
+// parse tree representing it, or NULL at the end of the input.
+Value *readDatum();
+
+// Reads the rest of the program, and returns a list of parse trees
+// representing its top-level data.
+Value *parse();
 
 
 // Prints the tree to the screen in a readable fashion. It should look just like
@@ -1,91 +1,777 @@
 #include <stdlib.h>
 #include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
 #include "value.h"
 #include <assert.h>
 
 #ifndef _TALLOC
 #define _TALLOC
 
-// define global list to hold pointers to allocated memory
-Value *memoryAddresses = NULL;
+// talloc hands out memory from large chunks with a bump pointer instead of
+// calling malloc for every request. Nothing is freed individually; tfree()
+// releases whole chunks at once. Each new chunk is twice the size of the last
+// (up to MAX_CHUNK_SIZE), so the number of chunks, and with it the cost of
+// tfree(), grows only logarithmically with the amount of memory allocated.
+
+// every allocation is aligned to this boundary, which is enough for any type
+#define TALLOC_ALIGN (sizeof(max_align_t))
+
+// usable size of the first regular chunk, and the cap on how far chunks grow
+#define CHUNK_SIZE (64 * 1024)
+#define MAX_CHUNK_SIZE (16 * 1024 * 1024)
+
+// requests larger than this get a chunk of their own, so that they don't waste
+// the remainder of the current chunk
+#define LARGE_ALLOCATION (CHUNK_SIZE / 4)
+
+// round size up to the next multiple of TALLOC_ALIGN
+#define ALIGN_UP(size) (((size) + TALLOC_ALIGN - 1) & ~(TALLOC_ALIGN - 1))
+
+// header at the start of each chunk; the usable bytes follow it
+typedef struct Chunk {
+    struct Chunk *next;
+    size_t size;
+    size_t used;
+} Chunk;
+
+// size of the chunk header, padded so that the first allocation is aligned
+#define CHUNK_HEADER ALIGN_UP(sizeof(Chunk))
+
+// define global list of chunks; the head is the chunk currently bumped into
+Chunk *chunks = NULL;
+
+// usable size of the next regular chunk to be allocated
+size_t nextChunkSize = CHUNK_SIZE;
+
+// newChunk
+// params: size - the number of usable bytes the chunk should hold
+// returns: a pointer to a new, empty Chunk
+// newChunk allocates a chunk with malloc, exiting the program if memory has run out
+Chunk *newChunk(size_t size) {
+    Chunk *chunk = malloc(CHUNK_HEADER + size);
+    if (chunk == NULL) {
+        printf("Memory error: out of memory\n");
+        exit(1);
+    }
+    chunk -> size = size;
+    chunk -> used = 0;
+    return chunk;
+}
+
+// total number of bytes handed out by talloc and gcAllocate, for measuring
+size_t allocatedBytes = 0;
+
+// bytesAllocated
+// params: None
+// returns: the number of bytes allocated with talloc or on the garbage-collected heap so far
+size_t bytesAllocated() {
+    return allocatedBytes;
+}
 
 // talloc
 // params: size - the number of bytes requested to allocate
 // returns: a pointer to the allocated block
-// talloc operates similary to malloc, but adds a pointer to the newly allocated memory to a global linked list
-// if the global linked list is NULL, it is initialized as a NULL_TYPE
+// talloc operates similary to malloc, but carves the block out of the current chunk by bumping its used count
+// if the current chunk is full, a new chunk is started; large requests are given a chunk of their own
 void *talloc(size_t size) {
-    // if our list has not yet been initialized
-    if (memoryAddresses == NULL) {
-        memoryAddresses = malloc(sizeof(Value));
-        memoryAddresses -> type = NULL_TYPE;
-        // return memoryAddresses;
-    }
-
-    // allocate space for pointer struct
-    Value *newItem = malloc(sizeof(Value));
-    newItem -> type = PTR_TYPE;
-    newItem -> p = malloc(size);
-
-    // allocate space for cons cell containing pointer struct
-    Value *consCell = malloc(sizeof(Value));
-    consCell -> type = CONS_TYPE;
-    consCell -> c.car = newItem;
-    consCell -> c.cdr = memoryAddresses;
-    memoryAddresses = consCell;
-
-    return newItem -> p;
-}
-
-// tfreeHelper
-// params: memoryAddress - a pointer to a Value
-// returns: Nothing
-// a helper function to tfree()
-void tfreeHelper(Value *memoryAddress) {
-    switch (memoryAddress -> type) {
-            case INT_TYPE:
-                break;
-            case DOUBLE_TYPE:
-                break;
-            case STR_TYPE:
-                break;
-            case OPEN_TYPE:
-                break;
-            case CLOSE_TYPE:
-                break;
-            case BOOL_TYPE:
-                break;
-            case SYMBOL_TYPE:
-                break;
-            case PTR_TYPE:
-                free(memoryAddress -> p);
-                free(memoryAddress);
-                break;
-            case CONS_TYPE:
-                tfreeHelper(memoryAddress -> c.car);
-                tfreeHelper(memoryAddress -> c.cdr);
-                free(memoryAddress);
-                break;
-            case NULL_TYPE:
-                free(memoryAddress);
-                break;
-            case VOID_TYPE:
-                break;
-            case CLOSURE_TYPE:
-                break;
-            default:
-                break;
+    size = ALIGN_UP(size);
+    allocatedBytes = allocatedBytes + size;
+
+    // large blocks go in a dedicated chunk placed behind the current one, so the current chunk keeps filling up
+    if (size > LARGE_ALLOCATION) {
+        Chunk *chunk = newChunk(size);
+        chunk -> used = size;
+        if (chunks == NULL) {
+            chunk -> next = NULL;
+            chunks = chunk;
+        } else {
+            chunk -> next = chunks -> next;
+            chunks -> next = chunk;
+        }
+        return (char *)chunk + CHUNK_HEADER;
+    }
+
+    // if our list has not yet been initialized, or the current chunk is out of room
+    if (chunks == NULL || chunks -> size - chunks -> used < size) {
+        Chunk *chunk = newChunk(nextChunkSize);
+        chunk -> next = chunks;
+        chunks = chunk;
+        if (nextChunkSize < MAX_CHUNK_SIZE) {
+            nextChunkSize = nextChunkSize * 2;
         }
+    }
+
+    void *block = (char *)chunks + CHUNK_HEADER + chunks -> used;
+    chunks -> used = chunks -> used + size;
+    return block;
+}
+
+// Values and Frames live on a separate, garbage-collected heap with two
+// generations. New objects are bump-allocated in a fixed-size nursery. When
+// the nursery fills up, a minor collection copies the nursery objects that are
+// still reachable into the old generation (promoting them) and empties the
+// nursery, so short-lived objects cost nothing to reclaim. The old generation
+// is a list of blocks; once it has grown enough, a major collection copies
+// every reachable object into one fresh block and frees the rest. Both kinds
+// of collection use Cheney's algorithm, so they take time proportional to the
+// data they copy and use no recursion.
+//
+// Collections only ever happen inside gcSafePoint(), so code that holds Value
+// or Frame pointers only needs to register them with gcPushRoot() while it
+// calls something that may reach a safe point. Everything else (the tokenizer,
+// the parser, cons(), the primitives) can keep raw pointers freely.
+//
+// A minor collection only looks at the roots, so an old object that is made
+// to point at a young one has to be reported with gcWriteBarrier(). Objects
+// allocated straight into the old generation (because the nursery was full
+// and no safe point came along, or because they are large) are scanned in
+// full at the next minor collection instead.
+
+// size of the nursery, and how little room may be left in it before a safe
+// point triggers a minor collection
+#define NURSERY_SIZE (1024 * 1024)
+#define NURSERY_RESERVE (16 * 1024)
+
+// objects larger than this are allocated in the old generation directly
+#define LARGE_OBJECT (NURSERY_SIZE / 8)
+
+// size of a regular old generation block
+#define HEAP_BLOCK_SIZE (256 * 1024)
+
+// a major collection is triggered once the old generation has grown by this
+// many bytes (or by as many bytes as survived the last major collection, if
+// that is more)
+#define MIN_COLLECT_BYTES (4 * 1024 * 1024)
+
+// kinds of objects on the heap; a string is a STR_TYPE Value followed by its
+// characters; a forwarded object has already been copied during the current
+// collection, and its first word holds the new address
+typedef enum {
+    GC_VALUE, GC_FRAME, GC_CONS, GC_STRING, GC_FORWARDED
+} gcKind;
+
+// set in the flags of an old object that is on the remembered set
+#define GC_REMEMBERED 1
+
+// header in front of every object on the heap; size is the payload size
+typedef struct GcHeader {
+    uint32_t size;
+    uint16_t kind;
+    uint16_t flags;
+} GcHeader;
+
+// the nursery, its bump pointer, and its end
+char *nursery = NULL;
+char *nurseryFree = NULL;
+char *nurseryEnd = NULL;
+
+// define global list of old generation blocks, oldest first; the tail is the block currently bumped into
+Chunk *heapBlocks = NULL;
+Chunk *heapTail = NULL;
+
+// the point in the old generation up to which objects were allocated before
+// the last collection; objects after it are scanned by the next minor collection
+Chunk *frontierBlock = NULL;
+size_t frontierOffset = 0;
+
+// bytes added to the old generation since the last major collection, and how
+// many may be added before the next one
+size_t promotedSinceCollect = 0;
+size_t collectThreshold = MIN_COLLECT_BYTES;
+
+// the number of major collections there have been, counting one in progress
+int majorCollections = 0;
+
+// the root stack holds the addresses of Value and Frame pointer variables
+void ***roots = NULL;
+int rootCount = 0;
+int rootCapacity = 0;
+
+// the remembered set holds old objects that have been made to point at young ones
+void **remembered = NULL;
+int rememberedCount = 0;
+int rememberedCapacity = 0;
+
+// a stack of roots kept outside the heap, given by the variables holding its base and its height
+void ***rootStack = NULL;
+int *rootStackHeight = NULL;
+
+// arrays of constants kept outside the heap; the ones from youngPools on were added since the last collection
+typedef struct ConstantPool {
+    void **constants;
+    int count;
+} ConstantPool;
+ConstantPool *pools = NULL;
+int poolCount = 0;
+int poolCapacity = 0;
+int youngPools = 0;
+
+// the function to call with the code of each closure a collection keeps, if one has been registered
+void (*closureVisitor)(struct Code *code) = NULL;
+
+// the block being copied into during a collection, and whether only the nursery is being collected
+Chunk *toSpace = NULL;
+bool minorCollection = false;
+
+// inNursery
+// params: object - a pointer to the payload of a heap object
+// returns: true if the object lives in the nursery, and false otherwise
+bool inNursery(void *object) {
+    return (char *)object >= nursery && (char *)object < nurseryEnd;
+}
+
+// growArray
+// params: array - an array allocated with malloc; capacity - a pointer to its capacity in elements
+// returns: the array, reallocated with twice the capacity
+// growArray exits the program if memory has run out
+void *growArray(void *array, int *capacity) {
+    *capacity = *capacity == 0 ? 256 : *capacity * 2;
+    array = realloc(array, *capacity * sizeof(void *));
+    if (array == NULL) {
+        printf("Memory error: out of memory\n");
+        exit(1);
+    }
+    return array;
+}
+
+// addOldBlock
+// params: size - the minimum number of usable bytes the block should hold
+// returns: Nothing
+// appends a new, empty block to the old generation, making it the block that is bumped into
+void addOldBlock(size_t size) {
+    Chunk *block = newChunk(size > HEAP_BLOCK_SIZE ? size : HEAP_BLOCK_SIZE);
+    block -> next = NULL;
+    if (heapTail == NULL) {
+        heapBlocks = block;
+        frontierBlock = block;
+        frontierOffset = 0;
+    } else {
+        heapTail -> next = block;
+    }
+    heapTail = block;
+}
+
+// allocateOld
+// params: total - the number of bytes needed, including the header
+// returns: a pointer to the start of the space
+// allocateOld bump-allocates space at the end of the old generation, adding a block if needed
+GcHeader *allocateOld(size_t total) {
+    if (heapTail == NULL || heapTail -> size - heapTail -> used < total) {
+        addOldBlock(total);
+    }
+    GcHeader *header = (GcHeader *)((char *)heapTail + CHUNK_HEADER + heapTail -> used);
+    heapTail -> used = heapTail -> used + total;
+    promotedSinceCollect = promotedSinceCollect + total;
+    return header;
+}
+
+// gcAllocate
+// params: size - the number of payload bytes requested; kind - the gcKind of the object
+// returns: a pointer to the payload of a new heap object
+// gcAllocate bump-allocates an object and its header in the nursery, or in the old generation if it does not fit
+// gcAllocate never collects, so pointers held by the caller stay valid
+void *gcAllocate(size_t size, gcKind kind) {
+    size_t total = (sizeof(GcHeader) + size + 7) & ~(size_t)7;
+    allocatedBytes = allocatedBytes + total;
+    if (nursery == NULL) {
+        nursery = malloc(NURSERY_SIZE);
+        if (nursery == NULL) {
+            printf("Memory error: out of memory\n");
+            exit(1);
+        }
+        nurseryFree = nursery;
+        nurseryEnd = nursery + NURSERY_SIZE;
+    }
+
+    GcHeader *header;
+    if (total <= LARGE_OBJECT && (size_t)(nurseryEnd - nurseryFree) >= total) {
+        header = (GcHeader *)nurseryFree;
+        nurseryFree = nurseryFree + total;
+    } else {
+        header = allocateOld(total);
+    }
+    header -> size = total - sizeof(GcHeader);
+    header -> kind = kind;
+    header -> flags = 0;
+    return header + 1;
+}
+
+// gcAllocValue
+// params: None
+// returns: a pointer to a new Value on the garbage-collected heap
+// the caller is responsible for setting the type and contents of the Value
+Value *gcAllocValue() {
+    return gcAllocate(sizeof(Value), GC_VALUE);
+}
+
+// gcAllocString
+// params: chars - a pointer to characters; length - how many of them to copy
+// returns: a pointer to a new STR_TYPE Value on the garbage-collected heap, holding a copy of the characters
+// the characters are stored right after the Value, in the same object, so they are collected along with it
+Value *gcAllocString(char *chars, int length) {
+    Value *value = gcAllocate(sizeof(Value) + length, GC_STRING);
+    value -> type = STR_TYPE;
+    value -> str.chars = (char *)(value + 1);
+    value -> str.length = length;
+    memcpy(value -> str.chars, chars, length);
+    return value;
+}
+
+// gcAllocCons
+// params: car - a pointer to a Value; cdr - a pointer to a Value
+// returns: a CONS_TYPE Value pointing to a new cons cell on the garbage-collected heap
+Value *gcAllocCons(Value *car, Value *cdr) {
+    ConsCell *cell = gcAllocate(sizeof(ConsCell), GC_CONS);
+    cell -> car = car;
+    cell -> cdr = cdr;
+    return (Value *)((uintptr_t)cell | CONS_TAG);
+}
+
+// gcAllocFrame
+// params: size - the number of slots in the Frame
+// returns: a pointer to a new Frame on the garbage-collected heap, with all of its slots NULL
+// the caller is responsible for setting the parent of the Frame
+Frame *gcAllocFrame(int size) {
+    Frame *frame = gcAllocate(sizeof(Frame) + size * sizeof(Value *), GC_FRAME);
+    frame -> size = size;
+    memset(frame -> slots, 0, size * sizeof(Value *));
+    return frame;
+}
+
+// gcPushRoot
+// params: slot - the address of a Value or Frame pointer variable
+// returns: Nothing
+// registers slot as a root; if a collection moves the object it points to, the variable is updated
+void gcPushRoot(void *slot) {
+    if (rootCount == rootCapacity) {
+        roots = growArray(roots, &rootCapacity);
+    }
+    roots[rootCount] = slot;
+    rootCount++;
+}
+
+// gcPopRoots
+// params: count - the number of roots to unregister
+// returns: Nothing
+// unregisters the count most recently pushed roots
+void gcPopRoots(int count) {
+    assert(count <= rootCount);
+    rootCount = rootCount - count;
+}
+
+// gcWriteBarrier
+// params: object - a pointer to a Value or Frame that has just had a pointer stored into it
+// returns: Nothing
+// adds object to the remembered set if it is old, so that the next minor collection finds what it points to
+void gcWriteBarrier(void *object) {
+    // a cons cell is remembered by its address rather than its tagged pointer
+    object = (void *)((uintptr_t)object & ~(uintptr_t)CONS_TAG);
+    if (inNursery(object)) {
+        return;
+    }
+    GcHeader *header = (GcHeader *)object - 1;
+    if (!(header -> flags & GC_REMEMBERED)) {
+        header -> flags = header -> flags | GC_REMEMBERED;
+        if (rememberedCount == rememberedCapacity) {
+            remembered = growArray(remembered, &rememberedCapacity);
+        }
+        remembered[rememberedCount] = object;
+        rememberedCount++;
+    }
+}
+
+// gcSetRootStack
+// params: stack - the address of the variable pointing to the stack's first entry; height - the address of the
+// variable holding the number of entries in use
+// returns: Nothing
+// registers every entry in use on the stack as a root; both variables are read at each collection
+void gcSetRootStack(void *stack, int *height) {
+    rootStack = stack;
+    rootStackHeight = height;
+}
+
+// gcAddConstants
+// params: constants - an array of Value pointers outside the heap; count - the number of entries
+// returns: Nothing
+// registers the entries as roots; since they never change, each minor collection only has to look at the arrays
+// added since the one before, whose objects it promotes
+void gcAddConstants(Value **constants, int count) {
+    if (poolCount == poolCapacity) {
+        poolCapacity = poolCapacity == 0 ? 64 : poolCapacity * 2;
+        pools = realloc(pools, poolCapacity * sizeof(ConstantPool));
+        if (pools == NULL) {
+            printf("Memory error: out of memory\n");
+            exit(1);
+        }
+    }
+    pools[poolCount].constants = (void **)constants;
+    pools[poolCount].count = count;
+    poolCount++;
+}
+
+// gcRemoveConstants
+// params: constants - an array of Value pointers registered with gcAddConstants
+// returns: Nothing
+// unregisters the array, so that objects only it refers to can be collected; arrays are nearly always removed in the
+// reverse of the order they were added, so the search starts from the most recent
+void gcRemoveConstants(Value **constants) {
+    int i = poolCount - 1;
+    while (i >= 0 && pools[i].constants != (void **)constants) {
+        i--;
+    }
+    if (i < 0) {
+        return;
+    }
+
+    for (int j = i; j < poolCount - 1; j++) {
+        pools[j] = pools[j + 1];
+    }
+    poolCount--;
+    if (i < youngPools) {
+        youngPools--;
+    }
+}
+
+// forward
+// params: object - a pointer to the payload of a heap object, an immediate Value, or NULL
+// returns: the address of the object once the collection is over
+// copies object into to-space unless it has already been copied, leaving a forwarding address behind
+// during a minor collection, old objects stay where they are
+void *forward(void *object) {
+    // immediate Values are not objects at all
+    if (object == NULL || isImmediate(object)) {
+        return object;
+    }
+    // a pointer to a cons cell is tagged, and so is its new address
+    uintptr_t tag = (uintptr_t)object & CONS_TAG;
+    object = (void *)((uintptr_t)object - tag);
+    if (minorCollection && !inNursery(object)) {
+        return (void *)((uintptr_t)object | tag);
+    }
+    GcHeader *header = (GcHeader *)object - 1;
+    if (header -> kind == GC_FORWARDED) {
+        return (void *)((uintptr_t)*(void **)object | tag);
+    }
+
+    size_t total = sizeof(GcHeader) + header -> size;
+    GcHeader *copy = (GcHeader *)((char *)toSpace + CHUNK_HEADER + toSpace -> used);
+    memcpy(copy, header, total);
+    copy -> flags = 0;
+    toSpace -> used = toSpace -> used + total;
+    if (header -> kind == GC_STRING) {
+        // the characters moved along with the string
+        Value *string = (Value *)(copy + 1);
+        string -> str.chars = (char *)(string + 1);
+    }
+
+    header -> kind = GC_FORWARDED;
+    *(void **)object = copy + 1;
+    return (void *)((uintptr_t)(copy + 1) | tag);
+}
+
+// scanObject
+// params: header - the header of an object that has been copied into to-space
+// returns: Nothing
+// forwards every heap pointer held by the object, updating its fields to point to the copies
+void scanObject(GcHeader *header) {
+    if (header -> kind == GC_FRAME) {
+        Frame *frame = (Frame *)(header + 1);
+        frame -> parent = forward(frame -> parent);
+        for (int i = 0; i < frame -> size; i++) {
+            frame -> slots[i] = forward(frame -> slots[i]);
+        }
+        return;
+    } else if (header -> kind == GC_CONS) {
+        ConsCell *cell = (ConsCell *)(header + 1);
+        cell -> car = forward(cell -> car);
+        cell -> cdr = forward(cell -> cdr);
+        return;
+    }
+
+    Value *value = (Value *)(header + 1);
+    switch (value -> type) {
+        case CLOSURE_TYPE:
+            // the code lives outside the heap, so only the visitor can tell that a closure still needs it
+            if (closureVisitor != NULL) {
+                closureVisitor(value -> cl.code);
+            }
+            value -> cl.frame = forward(value -> cl.frame);
+            break;
+        case LOCAL_TYPE:
+            value -> lr.symbol = forward(value -> lr.symbol);
+            value -> lr.next = forward(value -> lr.next);
+            break;
+        default:
+            // no other type points at heap objects; a string's characters are part of it, or static
+            break;
+    }
+}
+
+// forwardRoots
+// params: None
+// returns: Nothing
+// forwards the object each registered root points to, updating the root variables
+void forwardRoots() {
+    for (int i = 0; i < rootCount; i++) {
+        *roots[i] = forward(*roots[i]);
+    }
+    if (rootStack != NULL) {
+        for (int i = 0; i < *rootStackHeight; i++) {
+            (*rootStack)[i] = forward((*rootStack)[i]);
+        }
+    }
+
+    // constants added before the last collection already point at old objects, which only a major collection moves
+    for (int i = minorCollection ? youngPools : 0; i < poolCount; i++) {
+        for (int j = 0; j < pools[i].count; j++) {
+            pools[i].constants[j] = forward(pools[i].constants[j]);
+        }
+    }
+    youngPools = poolCount;
+}
+
+// minorCollect
+// params: None
+// returns: Nothing
+// promotes everything in the nursery that is reachable from the roots, the remembered set, or objects added to
+// the old generation since the last collection, then empties the nursery
+void minorCollect() {
+    // make sure the survivors, which are at most the whole nursery, fit in the current old block
+    size_t nurseryUsed = nurseryFree - nursery;
+    if (heapTail == NULL || heapTail -> size - heapTail -> used < nurseryUsed) {
+        addOldBlock(nurseryUsed);
+    }
+    toSpace = heapTail;
+    minorCollection = true;
+    size_t promotedBefore = toSpace -> used;
+
+    forwardRoots();
+    for (int i = 0; i < rememberedCount; i++) {
+        GcHeader *header = (GcHeader *)remembered[i] - 1;
+        header -> flags = header -> flags & ~GC_REMEMBERED;
+        scanObject(header);
+    }
+    rememberedCount = 0;
+
+    // scan everything after the frontier: first the objects allocated straight into the old generation, then the
+    // objects promoted by this collection, which are appended to the tail block as they are found
+    Chunk *block = frontierBlock;
+    size_t scanned = frontierOffset;
+    while (block != NULL) {
+        while (scanned < block -> used) {
+            GcHeader *header = (GcHeader *)((char *)block + CHUNK_HEADER + scanned);
+            scanObject(header);
+            scanned = scanned + sizeof(GcHeader) + header -> size;
+        }
+        block = block -> next;
+        scanned = 0;
+    }
+
+    promotedSinceCollect = promotedSinceCollect + toSpace -> used - promotedBefore;
+    frontierBlock = heapTail;
+    frontierOffset = heapTail -> used;
+    nurseryFree = nursery;
+    minorCollection = false;
+    toSpace = NULL;
+}
+
+// majorCollect
+// params: None
+// returns: Nothing
+// copies everything reachable from the roots, in either generation, into a single new old block, then frees the
+// old blocks and empties the nursery
+void majorCollect() {
+    majorCollections++;
+
+    // everything currently on the heap fits in a block of the total size in use
+    size_t inUse = nurseryFree - nursery;
+    Chunk *block = heapBlocks;
+    while (block != NULL) {
+        inUse = inUse + block -> used;
+        block = block -> next;
+    }
+    toSpace = newChunk(inUse);
+    toSpace -> next = NULL;
+
+    forwardRoots();
+
+    // scan copied objects in order; copying appends to to-space, so this ends when nothing new is reachable
+    size_t scanned = 0;
+    while (scanned < toSpace -> used) {
+        GcHeader *header = (GcHeader *)((char *)toSpace + CHUNK_HEADER + scanned);
+        scanObject(header);
+        scanned = scanned + sizeof(GcHeader) + header -> size;
+    }
+
+    block = heapBlocks;
+    while (block != NULL) {
+        Chunk *next = block -> next;
+        free(block);
+        block = next;
+    }
+    heapBlocks = toSpace;
+    heapTail = toSpace;
+    frontierBlock = toSpace;
+    frontierOffset = toSpace -> used;
+    nurseryFree = nursery;
+    rememberedCount = 0;
+    toSpace = NULL;
+
+    // let the old generation grow to about twice the live data before collecting it again
+    promotedSinceCollect = 0;
+    collectThreshold = heapTail -> used > MIN_COLLECT_BYTES ? heapTail -> used : MIN_COLLECT_BYTES;
+}
+
+// gcSafePoint
+// params: None
+// returns: Nothing
+// runs a minor collection if the nursery is nearly full, and a major collection if the old generation has grown enough
+// every Value or Frame pointer that the caller (or its callers) will use afterwards must be registered with gcPushRoot()
+void gcSafePoint() {
+    if (nursery == NULL) {
+        return;
+    }
+    bool oldGrew = heapTail != NULL && (frontierBlock != heapTail || frontierOffset != heapTail -> used);
+    if (nurseryEnd - nurseryFree < NURSERY_RESERVE || oldGrew) {
+        minorCollect();
+        if (promotedSinceCollect >= collectThreshold) {
+            majorCollect();
+        }
+    }
+}
+
+// gcCollect
+// params: None
+// returns: Nothing
+// runs a minor collection whether or not the nursery is full, followed by a major collection if the old generation
+// has grown enough
+// every Value or Frame pointer that the caller (or its callers) will use afterwards must be registered with gcPushRoot()
+void gcCollect() {
+    if (nursery == NULL) {
+        return;
+    }
+    minorCollect();
+    if (promotedSinceCollect >= collectThreshold) {
+        majorCollect();
+    }
+}
+
+// gcClosureVisitor
+// params: visit - a function that takes the code of a closure
+// returns: Nothing
+// makes visit the function that scanObject() calls with the code of each closure it scans, replacing any registered
+// before
+void gcClosureVisitor(void (*visit)(struct Code *code)) {
+    closureVisitor = visit;
+}
+
+// gcMajorCollections
+// params: None
+// returns: the number of major collections there have been since the collector was last reset, counting one in
+// progress
+int gcMajorCollections() {
+    return majorCollections;
+}
+
+// gcFree
+// params: None
+// returns: Nothing
+// frees the nursery, every old block, the root stack, the remembered set and the constant pools, forgets the closure
+// visitor, and resets the collector to its initial state
+void gcFree() {
+    Chunk *block = heapBlocks;
+    while (block != NULL) {
+        Chunk *next = block -> next;
+        free(block);
+        block = next;
+    }
+    heapBlocks = NULL;
+    heapTail = NULL;
+    frontierBlock = NULL;
+    frontierOffset = 0;
+    promotedSinceCollect = 0;
+    collectThreshold = MIN_COLLECT_BYTES;
+    majorCollections = 0;
+
+    free(nursery);
+    nursery = NULL;
+    nurseryFree = NULL;
+    nurseryEnd = NULL;
+
+    free(roots);
+    roots = NULL;
+    rootCount = 0;
+    rootCapacity = 0;
+
+    free(remembered);
+    remembered = NULL;
+    rememberedCount = 0;
+    rememberedCapacity = 0;
+
+    rootStack = NULL;
+    rootStackHeight = NULL;
+
+    free(pools);
+    pools = NULL;
+    poolCount = 0;
+    poolCapacity = 0;
+    youngPools = 0;
+
+    closureVisitor = NULL;
+}
+
+// the most functions that can be waiting for the next tfree()
+#define MAX_TFREE_HOOKS 16
+
+// functions to call at the start of the next tfree(), in the order they were registered
+void (*tfreeHooks[MAX_TFREE_HOOKS])();
+int tfreeHookCount = 0;
+
+// tfreeHook
+// params: reset - a function that takes no arguments
+// returns: Nothing
+// registers reset to be called once, at the start of the next tfree(), unless it is registered already; the list lives
+// outside talloc's chunks, so it survives tfree() itself
+void tfreeHook(void (*reset)()) {
+    for (int i = 0; i < tfreeHookCount; i++) {
+        if (tfreeHooks[i] == reset) {
+            return;
+        }
+    }
+    if (tfreeHookCount == MAX_TFREE_HOOKS) {
+        printf("Memory error: too many tfree hooks\n");
+        exit(1);
+    }
+    tfreeHooks[tfreeHookCount] = reset;
+    tfreeHookCount++;
 }
 
 // tfree
 // params: None
 // returns: Nothing
-// calls tfreeHelper() to recursively free all pointers to blocks of memory allocated by talloc
-// resets the global linked list to NULL
+// frees every chunk allocated by talloc, which releases all blocks handed out at once
+// walks the chunk list iteratively, so its cost and stack use don't depend on how many blocks were handed out
+// also frees the garbage-collected heap
+// resets the global list of chunks to NULL, so that talloc can be used again afterwards
+// first calls the functions registered with tfreeHook, so that nothing else is left pointing at what is freed
 void tfree() {
-    tfreeHelper(memoryAddresses);
-    memoryAddresses = NULL;
+    for (int i = 0; i < tfreeHookCount; i++) {
+        tfreeHooks[i]();
+    }
+    tfreeHookCount = 0;
+
+    Chunk *current = chunks;
+    while (current != NULL) {
+        Chunk *next = current -> next;
+        free(current);
+        current = next;
+    }
+    chunks = NULL;
+    nextChunkSize = CHUNK_SIZE;
+    gcFree();
 }
 
 // texit
@@ -97,4 +783,4 @@ void texit(int status) {
     exit(status);
 }
 
-#endif
\ No newline at end of file
+#endif
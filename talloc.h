@@ -4,21 +4,98 @@
 #ifndef _TALLOC
 #define _TALLOC
 
-// Replacement for malloc that stores the pointers allocated. It should store
-// the pointers in some kind of list; a linked list would do fine, but insert
-// here whatever code you'll need to do so; don't call functions in the
-// pre-existing linkedlist.h. Otherwise you'll end up with circular
-// dependencies, since you're going to modify the linked list to use talloc.
+// Replacement for malloc that carves blocks out of large chunks with a bump
+// pointer, so that allocating costs a few instructions rather than a malloc
+// call. Don't call functions in the pre-existing linkedlist.h from here.
+// Otherwise you'll end up with circular dependencies, since the linked list
+// uses talloc.
 void *talloc(size_t size);
 
-// Free all pointers allocated by talloc, as well as whatever memory you
-// allocated in lists to hold those pointers.
+// Free all blocks allocated by talloc, by releasing the chunks they were
+// carved from, along with the garbage-collected heap described below.
 void tfree();
 
+// Register a function for the next tfree to call before it frees anything. A
+// module that keeps pointers to talloc's blocks or to the garbage-collected
+// heap in global variables registers one when it first stores such a pointer,
+// to reset them, so that it starts afresh if it is used again after tfree.
+// Each function is called once and then forgotten; registering one that is
+// already waiting does nothing.
+void tfreeHook(void (*reset)());
+
+// Return the total number of bytes allocated with talloc and on the
+// garbage-collected heap since the program started, tfree notwithstanding.
+size_t bytesAllocated();
+
 // Replacement for the C function "exit", that consists of two lines: it calls
 // tfree before calling exit. It's useful to have later on; if an error happens,
 // you can exit your program, and all memory is automatically cleaned up.
 void texit(int status);
 
+// Allocate a Value or Frame on the garbage-collected heap. Unlike talloc,
+// memory allocated this way is reclaimed once it is no longer reachable from
+// the registered roots. Allocating never collects by itself. A new Frame has
+// room for size slots, all NULL.
+Value *gcAllocValue();
+Frame *gcAllocFrame(int size);
+
+// Allocate a STR_TYPE Value on the garbage-collected heap, holding a copy of
+// the first length characters of chars, which are stored in the same object.
+Value *gcAllocString(char *chars, int length);
+
+// Allocate a cons cell on the garbage-collected heap, returning the tagged
+// CONS_TYPE Value pointing to it (see value.h).
+Value *gcAllocCons(Value *car, Value *cdr);
+
+// Register the address of a Value or Frame pointer variable as a root, so
+// that whatever it points to survives a collection and the variable is
+// updated if the object moves. Roots are unregistered in last-in, first-out
+// order with gcPopRoots.
+void gcPushRoot(void *slot);
+void gcPopRoots(int count);
+
+// Register a stack of Value or Frame pointers that is kept outside the heap,
+// given the address of the variable pointing to its first entry and the
+// address of the variable holding the number of entries in use. Every entry
+// in use is a root. The stack may be reallocated at any time, since both
+// variables are read afresh at each collection.
+void gcSetRootStack(void *stack, int *height);
+
+// Register an array of Value pointers kept outside the heap (the constants of
+// compiled code) as roots. The entries must never be changed afterwards, and
+// neither may the Values they point to.
+void gcAddConstants(Value **constants, int count);
+
+// Unregister an array added with gcAddConstants, once the code it belongs to
+// will never run again.
+void gcRemoveConstants(Value **constants);
+
+// Register the function that each collection calls with the code of every
+// closure it keeps. Compiled code lives outside the heap, so this is how the
+// compiler learns which code a closure may still need. Registering another
+// function replaces the first, and tfree forgets it.
+void gcClosureVisitor(void (*visit)(struct Code *code));
+
+// Return how many major collections there have been since tfree, counting
+// one in progress. A major collection goes through the whole heap rather than
+// just the recently allocated objects, so it visits every closure still
+// reachable, and a minor collection visits every one younger than that.
+int gcMajorCollections();
+
+// Report that a pointer has just been stored into an existing Value or Frame
+// (as opposed to one that is still being initialized right after allocation).
+// Recently allocated objects are collected separately from older ones, and
+// this is how the collector learns that an older object now refers to a newer
+// one.
+void gcWriteBarrier(void *object);
+
+// Collect garbage if enough has been allocated since the last collection.
+// Objects may move here, so any pointer the caller or its callers still need
+// must be reachable from a registered root.
+void gcSafePoint();
+
+// Collect garbage now, as gcSafePoint does once enough has been allocated.
+void gcCollect();
+
 #endif
 
@@ -1,266 +1,446 @@
 #include "value.h"
 #include "linkedlist.h"
 #include "talloc.h"
+#include "output.h"
+#include "number.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <errno.h>
 
 #ifndef _TOKENIZER
 #define _TOKENIZER
 
+// The symbol table stores every distinct symbol name exactly once, so that
+// symbols can be compared by pointer rather than with strcmp. It is an open
+// addressing hash table of names allocated with talloc, kept at most half full.
+
+// define global symbol table, along with its number of slots and entries
+char **symbolTable = NULL;
+int symbolTableSize = 0;
+int symbolCount = 0;
+
+// hashName
+// args: name - a string; length - the number of characters of name to hash
+// returns: the FNV-1a hash of the first length characters of name
+unsigned long hashName(char *name, int length) {
+    unsigned long hash = 2166136261u;
+    for (int i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// resetSymbols
+// args: None
+// returns: nothing
+// resetSymbols empties the symbol table, whose slots and names tfree() is about to free
+void resetSymbols() {
+    symbolTable = NULL;
+    symbolTableSize = 0;
+    symbolCount = 0;
+}
+
+// growSymbolTable
+// args: None
+// returns: nothing
+// growSymbolTable doubles the number of slots in the symbol table, rehashing every name into the new slots
+// creating the table registers resetSymbols() with tfreeHook()
+void growSymbolTable() {
+    int oldSize = symbolTableSize;
+    char **oldTable = symbolTable;
+    if (oldSize == 0) {
+        tfreeHook(resetSymbols);
+    }
+    symbolTableSize = oldSize == 0 ? 256 : oldSize * 2;
+    symbolTable = talloc(symbolTableSize * sizeof(char *));
+    for (int i = 0; i < symbolTableSize; i++) {
+        symbolTable[i] = NULL;
+    }
+
+    for (int i = 0; i < oldSize; i++) {
+        if (oldTable[i] != NULL) {
+            unsigned long slot = hashName(oldTable[i], strlen(oldTable[i])) & (symbolTableSize - 1);
+            while (symbolTable[slot] != NULL) {
+                slot = (slot + 1) & (symbolTableSize - 1);
+            }
+            symbolTable[slot] = oldTable[i];
+        }
+    }
+}
+
+// internSymbol
+// args: name - a string; length - the number of characters in the symbol's name
+// returns: the single stored copy of the symbol's name, as a null-terminated string
+// internSymbol adds the name to the symbol table the first time it is seen
+char *internSymbol(char *name, int length) {
+    if (2 * (symbolCount + 1) > symbolTableSize) {
+        growSymbolTable();
+    }
+
+    unsigned long slot = hashName(name, length) & (symbolTableSize - 1);
+    while (symbolTable[slot] != NULL) {
+        if (!strncmp(symbolTable[slot], name, length) && symbolTable[slot][length] == '\0') {
+            return symbolTable[slot];
+        }
+        slot = (slot + 1) & (symbolTableSize - 1);
+    }
+
+    char *interned = talloc((length + 1) * sizeof(char));
+    memcpy(interned, name, length);
+    interned[length] = '\0';
+    symbolTable[slot] = interned;
+    symbolCount++;
+    return interned;
+}
+
+// The input is scanned with a pointer, cursor, rather than read a character at
+// a time. A file given by path is mapped into memory as it stands. stdin is
+// read in large blocks as the scanner reaches the end of what it has, so
+// tokens can be handed out before all of the input has arrived; a token that
+// straddles the end of a block is moved to the start of the next one.
+// Looking ahead is a matter of reading past cursor, which only moves once a
+// token is complete, so nothing is ever pushed back. No token points into the
+// input: symbols are interned from it and strings copied out of it, so the
+// input before cursor is released as the scanner goes. A block of stdin is
+// freed once what is left of it has been moved to the next, and the pages of a
+// mapped file that cursor has passed are handed back every RELEASE_SIZE bytes.
+
+// size of the blocks stdin is read in
+#define READ_BLOCK_SIZE (64 * 1024)
+
+// how far cursor gets past the part of a mapped file still held before that part is released
+#define RELEASE_SIZE (1024 * 1024)
+
+// define global block of input read from stdin, along with the position of the next character to be scanned, the end
+// of the input read so far, and the end of the space in the block
+char *inputBlock = NULL;
+char *cursor = NULL;
+char *inputEnd = NULL;
+char *blockEnd = NULL;
+
+// the file descriptor still being read, or -1 once its end has been reached or if the input is a mapped file
+int inputFile = -1;
+
+// the mapping of the input file, its length, and the start of the pages of it not yet released
+char *mapping = NULL;
+size_t mappedLength = 0;
+char *unreleased = NULL;
+
+// openInput
+// args: path - the path of the file to read, or NULL to read stdin
+// returns: nothing
+// openInput makes the file at path, mapped into memory read-only, or else stdin, the input that tokens are read from
+// exits the program if the file can't be read
+void openInput(char *path) {
+    if (path == NULL) {
+        inputFile = 0;
+        return;
+    }
+
+    int file = open(path, O_RDONLY);
+    struct stat status;
+    if (file < 0 || fstat(file, &status) < 0) {
+        printf("File error: could not read %s\n", path);
+        exit(1);
+    }
+
+    // an empty file can't be mapped, and needs no buffer anyway
+    if (status.st_size > 0) {
+        mapping = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (mapping == MAP_FAILED) {
+            printf("File error: could not read %s\n", path);
+            exit(1);
+        }
+        madvise(mapping, status.st_size, MADV_SEQUENTIAL);
+        mappedLength = status.st_size;
+    }
+    close(file);
+
+    cursor = mapping;
+    inputEnd = mapping + mappedLength;
+    unreleased = mapping;
+}
+
+// refill
+// args: None
+// returns: true if more input was read, or false at the end of the input
+// refill reads the next block of stdin after inputEnd. If the current block is full, the characters from cursor on
+// are moved to the start of a new block first, which is at least twice their size so that a long token is moved only
+// a logarithmic number of times, and the old block is freed.
+bool refill() {
+    if (inputFile < 0) {
+        return false;
+    }
+
+    if (blockEnd - inputEnd < READ_BLOCK_SIZE / 16) {
+        size_t kept = inputEnd - cursor;
+        size_t size = kept * 2 > READ_BLOCK_SIZE ? kept * 2 : READ_BLOCK_SIZE;
+        char *block = malloc(size);
+        if (block == NULL) {
+            printf("Memory error: out of memory\n");
+            exit(1);
+        }
+        if (kept > 0) {
+            memcpy(block, cursor, kept);
+        }
+        free(inputBlock);
+        inputBlock = block;
+        cursor = block;
+        inputEnd = block + kept;
+        blockEnd = block + size;
+    }
+
+    // read returns whatever is available, so a pipe's contents are scanned as soon as they arrive; whatever has been
+    // printed is flushed first, since reading may wait for the writer, which may be waiting for that output
+    fflush(stdout);
+    ssize_t count = read(inputFile, inputEnd, blockEnd - inputEnd);
+    while (count < 0 && errno == EINTR) {
+        count = read(inputFile, inputEnd, blockEnd - inputEnd);
+    }
+    if (count <= 0) {
+        inputFile = -1;
+        return false;
+    }
+    inputEnd = inputEnd + count;
+    return true;
+}
+
+// peek
+// args: offset - how far past cursor to look
+// returns: the character offset characters past cursor, or EOF if the input ends before it
+// peek reads more input if needed, which may move the characters from cursor on, so pointers into the current token
+// must not be kept across calls to it
+int peek(int offset) {
+    while (inputEnd - cursor <= offset) {
+        if (!refill()) {
+            return EOF;
+        }
+    }
+    return (unsigned char)cursor[offset];
+}
+
+// isDigit
+// args: c - a character, or EOF
+// returns: true if c is a decimal digit
+bool isDigit(int c) {
+    return 48 <= c && c <= 57;
+}
+
+// isSymbolChar
+// args: c - a character, or EOF
+// returns: true if c may appear in a symbol after its first character
+bool isSymbolChar(int c) {
+    return (65 <= c && c <= 90) || (97 <= c && c <= 122)
+            || c == '!' || c == '$' || c == '%' || c == '&'
+            || c == '*' || c == '/' || c == ':' || c == '<'
+            || c == '=' || c == '>' || c == '?' || c == '~'
+            || c == '_' || c == '^' || c == '+' || c == '-'
+            || c == '.' || isDigit(c);
+}
+
+// endsAtom
+// args: c - a character, or EOF
+// returns: true if c may follow a number or symbol: whitespace, a parenthesis or the end of the input
+bool endsAtom(int c) {
+    return c == ' ' || c == EOF || c == '\n' || c == '(' || c == ')';
+}
+
+// isInfOrNaN
+// args: None
+// returns: true if the input at cursor is +inf.0, -inf.0, +nan.0 or -nan.0, followed by the end of the atom
+bool isInfOrNaN() {
+    if ((peek(0) != '+' && peek(0) != '-') || (peek(1) != 'i' && peek(1) != 'n')) {
+        return false;
+    }
+    char *spelling = peek(1) == 'i' ? "inf.0" : "nan.0";
+    for (int i = 1; i < 5; i++) {
+        if (peek(1 + i) != spelling[i]) {
+            return false;
+        }
+    }
+    return endsAtom(peek(6));
+}
+
 // processString
 // args: None
-// returns: newString - a string
-// helper method for tokenize() to parse the body of a string. Throws an error and exits if the string is invalid.
-char *processString() {
-    char charRead;
-    int index = 0;
-    char *newString = talloc(301*sizeof(char));  // 301 bytes allocated since max token size of 300, plus null terminator
-    newString[0] = '\"';
-    index++;
-    charRead = (char)fgetc(stdin);
-
-    // continue reading char's from the input stream until end of string or end of file
-    while (charRead != '\"') {
-        
+// returns: a Value of STR_TYPE containing the read string
+// helper method for nextToken() to tokenize the string starting at cursor, moving cursor past it. The token holds a
+// copy of the string's text, quotes included, so that the input can be released. Throws an error and exits if the
+// string is invalid.
+Value *processString() {
+    int searched = 1;
+    char *closingQuote = memchr(cursor + searched, '\"', inputEnd - (cursor + searched));
+
+    // read on until the closing double-quote turns up
+    while (closingQuote == NULL) {
+        searched = inputEnd - cursor;
+
         // in the event there is no closing double-quote, throw syntax error
-        if (charRead == EOF) { 
+        if (!refill()) {
             printf("Syntax Error: Invalid String\n");
             texit(0);
         }
-        newString[index] = charRead;
-        index++;
-        charRead = (char)fgetc(stdin);
+        closingQuote = memchr(cursor + searched, '\"', inputEnd - (cursor + searched));
     }
-    newString[index] = '\"';
-    index++;
-    newString[index] = '\0';
-    
-    return newString;
+
+    Value *newToken = gcAllocString(cursor, closingQuote + 1 - cursor);
+    cursor = closingQuote + 1;
+    return newToken;
 }
 
 // processNumber
-// args: initialChar - a character
+// args: None
 // returns: a Value of type INT_TYPE or DOUBLE_TYPE, containing an integer or double respectively
-// helper method for tokenize(), to identify and tokenize signed and unsigned integer and double numbers
-Value *processNumber(char initialChar) {
-    char charRead = initialChar;
-    int index = 0;
-    char *newNumber = talloc(301*sizeof(char));  // 301 bytes allocated since max token size of 300, plus null terminator
-    char *dump;  // dump location for excess string contents when converting strings to longs/doubles
+// helper method for nextToken(), to identify and tokenize the signed or unsigned integer or double number starting at
+// cursor, moving cursor past it. A double has a decimal point, an exponent or both, or is one of +inf.0, -inf.0,
+// +nan.0 and -nan.0.
+Value *processNumber() {
+    int length = 0;
+    bool isDouble = false;
 
     // if number is signed, include sign
-    if (charRead == '+' || charRead == '-') {
-        newNumber[index] = charRead;
-        index++;
-        charRead = (char)fgetc(stdin);
+    if (peek(0) == '+' || peek(0) == '-') {
+        length++;
     }
 
-    // build up number digit by digit, while reading consecutive digits
-    while (48 <= charRead && charRead <= 57) {
-        newNumber[index] = charRead;
-        index++;
-        charRead = (char)fgetc(stdin);
+    // the infinities and NaN are doubles spelled out, as formatDouble() writes them
+    if (isInfOrNaN()) {
+        isDouble = true;
+        length = 6;
     }
 
-    // create new INT_TYPE token containing the built-up number
-    if (charRead == ' ' || charRead == EOF || charRead == '\n') {
-        newNumber[index] = '\0';
-        int number = strtol(newNumber, &dump, 10);
-        Value *newToken = talloc(sizeof(Value));
-        newToken -> type = INT_TYPE;
-        newToken -> i = number;
-        return newToken;
+    // scan the number digit by digit, while reading consecutive digits
+    while (isDigit(peek(length))) {
+        length++;
+    }
 
-    // create new INT_TYPE token, but rewind stream by 1 so parentheses will be caught by tokenize()
-    } else if (charRead == '(' || charRead == ')') {
-        newNumber[index] = '\0';
-        int number = strtol(newNumber, &dump, 10);
-        Value *newToken = talloc(sizeof(Value));
-        newToken -> type = INT_TYPE;
-        newToken -> i = number;
-        ungetc(charRead, stdin);
-        return newToken;
-    
-    // Recognize . symbol to build double
-    } else if (charRead == '.') {
-
-        newNumber[index] = charRead;
-        index++;
-        charRead = (char)fgetc(stdin);
-
-        // building up double portion of double number
-        while (48 <= charRead && charRead <= 57) {
-            newNumber[index] = charRead;
-            index++;
-            charRead = (char)fgetc(stdin);
+    // Recognize . symbol to build double, and scan its fractional part
+    if (peek(length) == '.') {
+        isDouble = true;
+        length++;
+        while (isDigit(peek(length))) {
+            length++;
         }
+    }
 
-        // Creating new DOUBLE_TYPE token, similar to integer case
-        if (charRead == ' ' || charRead == EOF || charRead == '\n') {
-            newNumber[index] = '\0';
-            double decimal = strtod(newNumber, &dump);
-            Value *newToken = talloc(sizeof(Value));
-            newToken -> type = DOUBLE_TYPE;
-            newToken -> d = decimal;
-            return newToken;
-            
-        // Create DOUBLE_TYPE token and rewind by one to catch parens
-        } else if (charRead == '(' || charRead == ')') {
-            newNumber[index] = '\0';
-            double decimal = strtod(newNumber, &dump);
-            Value *newToken = talloc(sizeof(Value));
-            newToken -> type = DOUBLE_TYPE;
-            newToken -> d = decimal;
-            ungetc(charRead, stdin);
-            return newToken;
-            
-    // if character read not in the language for numbers, throw syntax error and exit the program
+    // an exponent, which may follow an integer too, makes a double
+    int exponentSign = peek(length + 1) == '+' || peek(length + 1) == '-';
+    if ((peek(length) == 'e' || peek(length) == 'E') && isDigit(peek(length + 1 + exponentSign))) {
+        isDouble = true;
+        length = length + 1 + exponentSign;
+        while (isDigit(peek(length))) {
+            length++;
+        }
+    }
 
-        } else {
+    // if character read not in the language for numbers, throw syntax error and exit the program
+    if (!endsAtom(peek(length))) {
+        if (isDouble) {
             printf("Syntax Error: Invalid double\n");
-            texit(0);
+        } else {
+            printf("Syntax Error: Invalid number\n");
         }
-
-    } else {
-        printf("Syntax Error: Invalid number\n");
         texit(0);
     }
 
-    // return case will never trigger, but placed to avoid compiler warning
-    return makeNull();
+    // create new DOUBLE_TYPE or INT_TYPE token containing the number, converted straight from the input
+    char *start = cursor;
+    cursor = cursor + length;
+    if (isDouble) {
+        Value *newToken = gcAllocValue();
+        newToken -> type = DOUBLE_TYPE;
+        newToken -> d = parseDouble(start, length);
+        return newToken;
+    }
+    return makeInt(parseInteger(start, length));
 }
 
 // processSymbol
-// args: initialChar - a char
+// args: None
 // returns: a Value of SYMBOL_TYPE containing the read symbol
-// helper function for tokenize(), to identify and tokenize symbols
-Value *processSymbol(char initialChar) {
-    char charRead = initialChar;
-    char *symbol = talloc(301*sizeof(char));
-    int index = 0;
-    symbol[0] = charRead;
-    index++;
-    charRead = (char)fgetc(stdin);
-
-    // continue reading char's until charRead does not equal a suitable character to be contained in a symbol
-    while ((65 <= charRead && charRead <= 90) || (97 <= charRead && charRead <= 122)
-            || charRead == '!' || charRead == '$' || charRead == '%' || charRead == '&'
-            || charRead == '*' || charRead == '/' || charRead == ':' || charRead == '<'
-            || charRead == '=' || charRead == '>' || charRead == '?' || charRead == '~'
-            || charRead == '_' || charRead == '^' || charRead == '+' || charRead == '-'
-            || charRead == '.' || (48 <= charRead && charRead <= 57)) {
-
-        symbol[index] = charRead;
-        index++;
-        charRead = (char)fgetc(stdin);
+// helper function for nextToken(), to identify and tokenize the symbol starting at cursor, moving cursor past it
+Value *processSymbol() {
+    int length = 1;
 
+    // continue scanning until the character does not equal a suitable character to be contained in a symbol
+    while (isSymbolChar(peek(length))) {
+        length++;
     }
 
-    // create new SYMBOL_TYPE token containing the built-up symbol
-    if (charRead == ' ' || charRead == EOF || charRead == '\n') {
-        symbol[index] = '\0';
-        Value *newToken = talloc(sizeof(Value));
-        newToken -> type = SYMBOL_TYPE;
-        newToken -> s = symbol;
-        return newToken;
-
-    // create new SYMBOL_TYPE token and rewind by one to catch parens
-    } else if (charRead == '(' || charRead == ')') {
-        symbol[index] = '\0';
-        Value *newToken = talloc(sizeof(Value));
-        newToken -> type = SYMBOL_TYPE;
-        newToken -> s = symbol;
-        ungetc(charRead, stdin);
-        return newToken;
-    
     // if character read not in the grammar for symbol, throw an error and exit the program
-    } else {
+    if (!endsAtom(peek(length))) {
         printf("Syntax Error: Invalid Symbol\n");
         texit(0);
     }
 
-    return makeNull();
+    // create new SYMBOL_TYPE token containing the scanned symbol, whose name is interned straight from the input
+    Value *newToken = gcAllocValue();
+    newToken -> type = SYMBOL_TYPE;
+    newToken -> s = internSymbol(cursor, length);
+    cursor = cursor + length;
+    return newToken;
 }
 
-// tokenize
+// releaseScanned
 // args: None
-// returns: a Value containing the first element in a linked-list of tokens
-// reads characters from stdin, and creates the appropriate tokens (or throws a syntax error if it reads an unexpected character)
-Value *tokenize() {
-    char charRead;
-    Value *list = makeNull();
-    charRead = (char)fgetc(stdin);
+// returns: nothing
+// releaseScanned hands the whole pages of the mapped file before cursor back to the kernel, which reads them from the
+// file again should they ever be touched
+void releaseScanned() {
+    size_t pageSize = sysconf(_SC_PAGESIZE);
+    char *end = mapping + (cursor - mapping) / pageSize * pageSize;
+    madvise(unreleased, end - unreleased, MADV_DONTNEED);
+    unreleased = end;
+}
+
+// nextToken
+// args: None
+// returns: a Value containing the next token in the input, or NULL at the end of the input
+// scans past whitespace and comments to the next token, and creates it (or throws a syntax error if it reads an
+// unexpected character)
+Value *nextToken() {
+    if (mapping != NULL && cursor - unreleased >= RELEASE_SIZE) {
+        releaseScanned();
+    }
+    int charRead = peek(0);
 
     while (charRead != EOF) {
 
         // case: open parenthesis
         if (charRead == '(') {
-            
-            Value *newToken = talloc(sizeof(Value));
-            newToken -> type = OPEN_TYPE;
-            char *newString = talloc(2*sizeof(char));
-            strcpy(newString, "(");
-            newToken -> s = newString;
-            list = cons(newToken, list);
+            cursor++;
+            return OPEN_VALUE;
 
         // case: close parenthesis
         } else if (charRead == ')') {
-
-            Value *newToken = talloc(sizeof(Value));
-            newToken -> type = CLOSE_TYPE;
-            char *newString = talloc(2*sizeof(char));
-            strcpy(newString, ")");
-            newToken -> s = newString;
-            list = cons(newToken, list);
+            cursor++;
+            return CLOSE_VALUE;
 
         // case: string
         } else if (charRead == '\"') {
-
-            char *processedString = processString();
-            Value *newToken = talloc(sizeof(Value));
-            newToken -> type = STR_TYPE;
-            newToken -> s = processedString;
-            list = cons(newToken, list);
+            return processString();
 
         // case: unsigned integer
-        } else if (48 <= charRead && charRead <= 57) {
-
-            Value *newToken = processNumber(charRead);
-            list = cons(newToken, list);
+        } else if (isDigit(charRead)) {
+            return processNumber();
 
         // case: signed number, or + - symbol
         } else if (charRead == '+' || charRead == '-') {
 
-            char sign = charRead;
-            charRead = (char)fgetc(stdin);
+            int following = peek(1);
 
             // subcase: +/- read as a symbol
-            if (charRead == ' ' || charRead == EOF || charRead == '\n'
-                || charRead == '(' || charRead == ')') {
-                ungetc(charRead, stdin);
-                Value *newToken = processSymbol(sign);
-                list = cons(newToken, list);
+            if (endsAtom(following)) {
+                return processSymbol();
             
             // subcase: +/- read as part of a number
-            } else if (48 <= charRead && charRead <= 57) {
-                ungetc(charRead, stdin);
-                Value *newToken = processNumber(sign);
-                list = cons(newToken, list);
-                
-            } else if (charRead == '.') {
-                
-                char point = charRead;
-                charRead = (char)fgetc(stdin);
-                if (48 <= charRead && charRead <= 57) {
-                    ungetc(charRead, stdin);
-                    ungetc(point, stdin);
-                    Value *newToken = processNumber(sign);
-                    list = cons(newToken, list);
-                } else {
-                    printf("Syntax Error: Invalid Symbol\n");
-                    texit(0);
-                }
+            } else if (isDigit(following) || (following == '.' && isDigit(peek(2))) || isInfOrNaN()) {
+                return processNumber();
 
             } else {
                 printf("Syntax Error: Invalid Symbol\n");
@@ -270,13 +450,8 @@ Value *tokenize() {
         // case: unsigned double
         } else if (charRead == '.') {
             
-            char point = charRead;
-            charRead = (char)fgetc(stdin);
-            
-            if (48 <= charRead && charRead <= 57) {
-                ungetc(charRead, stdin);
-                Value *newToken = processNumber('.');
-                list = cons(newToken, list);
+            if (isDigit(peek(1))) {
+                return processNumber();
             } else {
                 printf("Syntax Error: Invalid double\n");
                 texit(0);
@@ -284,17 +459,13 @@ Value *tokenize() {
 
         // case: boolean
         } else if (charRead == '#') {
-            charRead = (char)fgetc(stdin);
-            if (charRead == 't') {
-                Value *newToken = talloc(sizeof(Value));
-                newToken -> type = BOOL_TYPE;
-                newToken -> i = 1;
-                list = cons(newToken, list);
-            } else if (charRead == 'f') {
-                Value *newToken = talloc(sizeof(Value));
-                newToken -> type = BOOL_TYPE;
-                newToken -> i = 0;
-                list = cons(newToken, list);
+            int following = peek(1);
+            if (following == 't') {
+                cursor = cursor + 2;
+                return makeBool(true);
+            } else if (following == 'f') {
+                cursor = cursor + 2;
+                return makeBool(false);
             } else {
                 printf("Syntax Error: Invalid Boolean\n");
                 texit(0);
@@ -306,27 +477,46 @@ Value *tokenize() {
                     || charRead == '*' || charRead == '/' || charRead == ':' || charRead == '<'
                     || charRead == '=' || charRead == '>' || charRead == '?' || charRead == '~'
                     || charRead == '_' || charRead == '^') {
-
-            Value* newToken = processSymbol(charRead);
-            list = cons(newToken, list);
+            return processSymbol();
         
-        // case: comment
+        // case: comment, which runs up to the end of the line; the input up to there is skipped a block at a time
         } else if (charRead == ';') {
-            while (charRead != '\n' && charRead != EOF) {
-                charRead = (char)fgetc(stdin);
+            char *newline = memchr(cursor, '\n', inputEnd - cursor);
+            while (newline == NULL) {
+                cursor = inputEnd;
+                if (!refill()) {
+                    return NULL;
+                }
+                newline = memchr(cursor, '\n', inputEnd - cursor);
             }
+            cursor = newline + 1;
+
+        // case: space/newline
+        } else if (charRead == ' ' || charRead == '\n') {
+            cursor++;
 
-        // case: invalid non-whitespace or EOF read
-        } else if (charRead != ' ' && charRead != '\n' && charRead != EOF) {
+        // case: invalid non-whitespace read
+        } else {
             printf("Syntax Error: Bad Syntax\n");
             texit(0);
-        
-        // case: space/newline/EOF    
-        } else {
-            // continue
         }
-        
-        charRead = (char)fgetc(stdin);
+
+        charRead = peek(0);
+    }
+
+    return NULL;
+}
+
+// tokenize
+// args: None
+// returns: a Value containing the first element in a linked-list of tokens
+// reads the rest of the input opened by openInput(), and tokenizes it
+Value *tokenize() {
+    Value *list = makeNull();
+    Value *token = nextToken();
+    while (token != NULL) {
+        list = cons(token, list);
+        token = nextToken();
     }
 
     // reverse the list to put tokens in order
@@ -334,6 +524,25 @@ Value *tokenize() {
     return revList;
 }
 
+// releaseInput
+// args: None
+// returns: nothing
+// releaseInput unmaps or frees what is left of the input read by nextToken()
+void releaseInput() {
+    if (mapping != NULL) {
+        munmap(mapping, mappedLength);
+        mapping = NULL;
+        mappedLength = 0;
+        unreleased = NULL;
+    }
+    free(inputBlock);
+    inputBlock = NULL;
+    cursor = NULL;
+    inputEnd = NULL;
+    blockEnd = NULL;
+    inputFile = -1;
+}
+
 // displayTokens
 // args: list - a pointer to a Value
 // returns: nothing
@@ -341,46 +550,43 @@ Value *tokenize() {
 void displayTokens(Value *list) {
     Value *currentItem = list;
     Value *currentCar;
-    while (currentItem -> type != NULL_TYPE) {
+    while (typeOf(currentItem) != NULL_TYPE) {
         currentCar = car(currentItem);
-        switch (currentCar -> type) {
+        switch (typeOf(currentCar)) {
             case INT_TYPE:
-                printf("%i:integer\n", currentCar -> i);
+                writeInt(intValue(currentCar));
+                writeString(":integer\n");
                 break;
             case DOUBLE_TYPE:
-                printf("%lf:double\n", currentCar -> d);
+                writeDouble(currentCar -> d);
+                writeString(":double\n");
                 break;
             case STR_TYPE:
-                printf("%s:string\n", currentCar -> s);
+                writeText(currentCar -> str.chars, currentCar -> str.length);
+                writeString(":string\n");
                 break;
             case PTR_TYPE:
-                printf("Pointer\n");
+                writeString("Pointer\n");
                 break;
             case OPEN_TYPE:
-                printf("%s:open\n", currentCar -> s);
+                writeString("(:open\n");
                 break;
             case CLOSE_TYPE:
-                printf("%s:close\n", currentCar -> s);
+                writeString("):close\n");
                 break;
             case BOOL_TYPE:
-                if (currentCar -> i == 1) {
-                    printf("#t:boolean\n");
-                } else {
-                    printf("#f:boolean\n");
-                }
+                writeString(boolValue(currentCar) ? "#t:boolean\n" : "#f:boolean\n");
                 break;
             case SYMBOL_TYPE:
-                printf("%s:symbol\n", currentCar -> s);
-                break;
-            case CONS_TYPE:
+                writeString(currentCar -> s);
+                writeString(":symbol\n");
                 break;
-            case NULL_TYPE:
-                break; 
             default:
                 break;
         }
         currentItem = cdr(currentItem);
     }
+    flushOutput();
 }
 
 #endif
\ No newline at end of file
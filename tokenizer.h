@@ -3,11 +3,30 @@
 #ifndef _TOKENIZER
 #define _TOKENIZER
 
-// Read all of the input from stdin, and return a linked list consisting of the
+// Makes the file at path the input that tokens are read from, or stdin if
+// path is NULL. A file is mapped into memory read-only and tokenized where it
+// lies; stdin is read a block at a time, as tokens are asked for.
+void openInput(char *path);
+
+// Returns the next token in the input, or NULL (not the NULL_TYPE Value) at the
+// end of the input. Parentheses are OPEN_VALUE and CLOSE_VALUE, and string
+// tokens refer to their text in the input, which stays allocated until
+// releaseInput().
+Value *nextToken();
+
+// Reads the rest of the input, and returns a linked list consisting of the
 // tokens.
 Value *tokenize();
 
+// Frees the input. No string read from it may be used afterwards.
+void releaseInput();
+
 // Displays the contents of the linked list as tokens, with type information
 void displayTokens(Value *list);
 
+// Returns the one stored copy of the symbol name made of the first length
+// characters of name. Every SYMBOL_TYPE Value's string comes from here, so two
+// symbols have the same name exactly when their strings are the same pointer.
+char *internSymbol(char *name, int length);
+
 #endif
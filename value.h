@@ -1,3 +1,6 @@
+#include <stdint.h>
+#include <stdbool.h>
+
 #ifndef _VALUE
 #define _VALUE
 
@@ -15,51 +18,173 @@ typedef enum {
     PRIMITIVE_TYPE,
 
     // Type below is new for final portion
-    UNSPECIFIED_TYPE
+    UNSPECIFIED_TYPE,
+
+    // Types below are produced by lexical addressing, and only appear in code
+    LOCAL_TYPE, SCOPE_TYPE
 } valueType;
 
+// The special forms. analyze() recognizes each one once, by the interned
+// address of its keyword, so nothing after it compares names.
+typedef enum {
+    NO_FORM, QUOTE_FORM, LAMBDA_FORM, LET_FORM, LETREC_FORM, IF_FORM,
+    DEFINE_FORM, SET_FORM, BEGIN_FORM
+} specialForm;
+
+// Compiled code; see compiler.h
+struct Code;
+
 struct Value {
     valueType type;
     union {
-        int i;
         double d;
         char *s;
         void *p;
-        struct ConsCell {
-            struct Value *car;
-            struct Value *cdr;
-        } c;
+
+        // A string: length characters starting at chars, which are not
+        // null-terminated. The string of a literal is its text as written,
+        // quotes included, copied out of the program's source by
+        // gcAllocString().
+        struct String {
+            char *chars;
+            int length;
+        } str;
         // For purposes of this project a closure is just another type of value,
         // containing everything needed to execute a user-defined function: (1)
-        // a list of formal parameter names; (2) a pointer to the function body;
-        // (3) a pointer to the environment frame in which the function was
+        // a pointer to the compiled function body, which also records the
+        // number of formal parameters and the size of a frame for a call; (2)
+        // a pointer to the environment frame in which the function was
         // created.
         struct Closure {
-            struct Value *paramNames;
-            struct Value *functionCode;
+            struct Code *code;
             struct Frame *frame;
         } cl;
+
+        // A variable reference that lexical addressing has resolved to a local
+        // variable: its value is in slot number slot of the frame depth levels
+        // up from the current one. symbol is the original SYMBOL_TYPE Value. A
+        // variable introduced by an internal define has no value until the
+        // define runs; until then, the reference means whatever next refers
+        // to (another LOCAL_TYPE Value, or a SYMBOL_TYPE Value for a global).
+        struct LocalRef {
+            int depth;
+            int slot;
+            struct Value *symbol;
+            struct Value *next;
+        } lr;
+
+        // Lexical addressing replaces the keyword at the head of a lambda, let
+        // or letrec form with one of these, recording how many slots the
+        // frames the form creates need.
+        struct ScopeHead {
+            specialForm form;
+            int frameSize;
+        } sh;
         
-        // A primitive style function; just a pointer to it, with the right
-        // signature (pf = primitive function)
-        struct Value *(*pf)(struct Value *);
+        // A primitive style function: a pointer to it, taking the number of
+        // arguments and a pointer to the first of them (pf = primitive
+        // function), the number of arguments it takes, or -1 for any number,
+        // and the error to report when it is called with a different number.
+        struct Primitive {
+            struct Value *(*function)(int, struct Value **);
+            int arity;
+            char *arityError;
+        } pf;
     };
 };
 
 typedef struct Value Value;
 
+// A cons cell is not a Value but just its two pointers, half the size. A
+// pointer to one is tagged, as described below, so that its type is known
+// without a type field.
+typedef struct ConsCell {
+    struct Value *car;
+    struct Value *cdr;
+} ConsCell;
+
+// Integers, booleans, the empty list, void and the unspecified value letrec
+// binds its variables to at first are immediate: the Value pointer
+// itself encodes them, and nothing is allocated. Heap objects are aligned to 8
+// bytes, which leaves the low bits of a real pointer clear. A pointer with its
+// lowest bit set is an integer, shifted left by one. A pointer whose low three
+// bits are 010 is another immediate, with its valueType in the next five bits
+// and a payload (the truth of a boolean) above those. A pointer whose low three
+// bits are 100 points to a ConsCell, CONS_TAG bytes before it. Since none of
+// these can be dereferenced as a Value, use typeOf() instead of the type
+// field, and the functions below to make and read integers and booleans.
+#define FIXNUM_TAG 1
+#define IMMEDIATE_TAG 2
+#define CONS_TAG 4
+#define IMMEDIATE(type, payload) ((Value *)(((uintptr_t)(payload) << 8) | ((uintptr_t)(type) << 3) | IMMEDIATE_TAG))
+
+// Each constant has exactly one representation, so it can be tested for with ==
+#define NULL_VALUE IMMEDIATE(NULL_TYPE, 0)
+#define FALSE_VALUE IMMEDIATE(BOOL_TYPE, 0)
+#define TRUE_VALUE IMMEDIATE(BOOL_TYPE, 1)
+#define VOID_VALUE IMMEDIATE(VOID_TYPE, 0)
+#define UNSPECIFIED_VALUE IMMEDIATE(UNSPECIFIED_TYPE, 0)
+#define OPEN_VALUE IMMEDIATE(OPEN_TYPE, 0)
+#define CLOSE_VALUE IMMEDIATE(CLOSE_TYPE, 0)
+
+#if UINTPTR_MAX <= UINT32_MAX
+#error "immediate integers need pointers wider than int"
+#endif
+
+// Returns whether value is encoded in the pointer rather than allocated.
+static inline bool isImmediate(const Value *value) {
+    return ((uintptr_t)value & (FIXNUM_TAG | IMMEDIATE_TAG)) != 0;
+}
+
+// Returns the type of any Value, immediate or not.
+static inline valueType typeOf(const Value *value) {
+    uintptr_t bits = (uintptr_t)value;
+    if (bits & FIXNUM_TAG) {
+        return INT_TYPE;
+    } else if (bits & IMMEDIATE_TAG) {
+        return (valueType)((bits >> 3) & 31);
+    } else if (bits & CONS_TAG) {
+        return CONS_TYPE;
+    }
+    return value -> type;
+}
+
+// Returns the cell a CONS_TYPE Value points to.
+static inline ConsCell *consCell(const Value *list) {
+    return (ConsCell *)((uintptr_t)list - CONS_TAG);
+}
+
+// Returns the immediate INT_TYPE Value for number.
+static inline Value *makeInt(int number) {
+    return (Value *)(((uintptr_t)(intptr_t)number << 1) | FIXNUM_TAG);
+}
+
+// Returns the number an INT_TYPE Value holds.
+static inline int intValue(const Value *value) {
+    return (int)((intptr_t)value >> 1);
+}
+
+// Returns the immediate BOOL_TYPE Value for truth.
+static inline Value *makeBool(bool truth) {
+    return truth ? TRUE_VALUE : FALSE_VALUE;
+}
+
+// Returns whether a BOOL_TYPE Value is #t.
+static inline bool boolValue(const Value *value) {
+    return value == TRUE_VALUE;
+}
+
 
-// A frame is a linked list of bindings, and a pointer to another frame.  A
-// binding is a variable name (represented as a string), and a pointer to the
-// Value it is bound to. I'm just going to put these in a flat list, with every
-// other element being a symbol, and the following element being the value. I
-// could do this via yet another data structure, but I think this will
-// ultimately take less coding. It also will require less modification of
-// existing code.
+// A frame is a fixed-size vector of slots, and a pointer to another frame.
+// Lexical addressing works out ahead of time which slot each local variable
+// lives in, so a slot that is still NULL has not been bound yet. The global
+// frame is the one frame without a parent; it has no slots, and its variables
+// are kept in a hash table by the interpreter instead.
 
 struct Frame {
-    struct Value *bindings;
     struct Frame *parent;
+    int size;
+    struct Value *slots[];
 };
 
 typedef struct Frame Frame;